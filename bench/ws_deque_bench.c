@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+/* Scaling benchmark for ws_deque: the same divide and conquer workload
+ * is scheduled once with a ws_deque per worker and once with a
+ * circular_queue per worker behind its own mutex, where thieves lock the
+ * victim's queue to take a task, for a growing number of threads.
+ *
+ * usage: ws_deque_bench [max threads] */
+
+#include <boislib/circular_queue.h>
+#include <boislib/ws_deque.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_WORKERS 64
+#define DEQUE_TASKS 1024
+#define RANGE_END (1ULL << 24)
+#define GRAIN 64
+#define MAX_TASKS (RANGE_END / GRAIN)
+#define ROUNDS 3
+
+struct task {
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct worker {
+	pthread_t thread;
+	struct ws_deque* deque;
+	struct queue queue;
+	pthread_mutex_t lock;
+	struct task** queue_buf;
+	struct task* tasks;
+	size_t task_cnt;
+	uint64_t sum;
+	uint32_t seed;
+};
+
+static struct worker workers[MAX_WORKERS];
+static unsigned int worker_cnt;
+static int use_locked;
+static atomic_size_t pending;
+
+static uint32_t next_random(uint32_t* seed) {
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+
+static int put_task(struct worker* self, struct task* task) {
+	int ret;
+
+	if (!use_locked)
+		return ws_deque_push(self->deque, task);
+
+	pthread_mutex_lock(&self->lock);
+	ret = queue_push(&self->queue, &task) != 0;
+	pthread_mutex_unlock(&self->lock);
+	return ret;
+}
+
+static struct task* locked_pop(struct worker* owner) {
+	struct task* task = NULL;
+	void* elmt;
+
+	pthread_mutex_lock(&owner->lock);
+	if ((elmt = queue_pop(&owner->queue)) != NULL) {
+		task = *(struct task**)elmt;
+	}
+	pthread_mutex_unlock(&owner->lock);
+	return task;
+}
+
+static struct task* get_task(struct worker* self) {
+	struct task* task = NULL;
+	struct worker* victim;
+
+	if (use_locked) {
+		task = locked_pop(self);
+	} else {
+		task = (struct task*)ws_deque_pop(self->deque);
+	}
+
+	if (task == NULL) {
+		victim = &workers[next_random(&self->seed) % worker_cnt];
+		if (victim != self && use_locked) {
+			task = locked_pop(victim);
+		} else if (victim != self) {
+			task = (struct task*)ws_deque_steal(victim->deque);
+		}
+	}
+	return task;
+}
+
+static void task_run(struct worker* self, const struct task* task) {
+	uint64_t begin = task->begin;
+	uint64_t end = task->end;
+	uint64_t middle, i;
+	struct task* half;
+
+	while (end - begin > GRAIN) {
+		middle = begin + ((end - begin) / 2);
+		half = &self->tasks[self->task_cnt++];
+		half->begin = middle;
+		half->end = end;
+		atomic_fetch_add(&pending, 1);
+		if (!put_task(self, half)) {
+			task_run(self, half);
+			atomic_fetch_sub(&pending, 1);
+		}
+		end = middle;
+	}
+
+	for (i = begin; i < end; i++) {
+		self->sum += i;
+	}
+}
+
+static void* worker_main(void* arg) {
+	struct worker* self = (struct worker*)arg;
+	struct task* task;
+
+	while (atomic_load(&pending) > 0) {
+		if ((task = get_task(self)) != NULL) {
+			task_run(self, task);
+			atomic_fetch_sub(&pending, 1);
+		}
+	}
+	return NULL;
+}
+
+static double run(unsigned int threads, int locked) {
+	unsigned int i;
+	uint64_t sum = 0;
+	struct timespec begin, end;
+	void* deque_buf;
+	size_t deque_size = ws_deque_footprint(DEQUE_TASKS);
+	size_t queue_size = DEQUE_TASKS * sizeof(struct task*);
+
+	worker_cnt = threads;
+	use_locked = locked;
+	for (i = 0; i < threads; i++) {
+		deque_buf = malloc(deque_size);
+		workers[i].queue_buf = malloc(queue_size);
+		workers[i].tasks = malloc(MAX_TASKS * sizeof(struct task));
+		workers[i].task_cnt = 0;
+		workers[i].sum = 0;
+		workers[i].seed = 2463534242u + i;
+		if (deque_buf == NULL || workers[i].queue_buf == NULL ||
+			workers[i].tasks == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		workers[i].deque = ws_deque_init(deque_buf, deque_size);
+		queue_init(&workers[i].queue, workers[i].queue_buf,
+				   sizeof(struct task*), queue_size);
+		pthread_mutex_init(&workers[i].lock, NULL);
+	}
+
+	workers[0].tasks[0].begin = 0;
+	workers[0].tasks[0].end = RANGE_END;
+	workers[0].task_cnt = 1;
+	atomic_store(&pending, 1);
+	put_task(&workers[0], &workers[0].tasks[0]);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < threads; i++) {
+		pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < threads; i++) {
+		sum += workers[i].sum;
+		pthread_mutex_destroy(&workers[i].lock);
+		free(workers[i].deque);
+		free(workers[i].queue_buf);
+		free(workers[i].tasks);
+	}
+	if (sum != RANGE_END * (RANGE_END - 1) / 2) {
+		fprintf(stderr, "wrong sum with %u threads\n", threads);
+		exit(1);
+	}
+
+	return (double)(end.tv_sec - begin.tv_sec) * 1e3 +
+		   (double)(end.tv_nsec - begin.tv_nsec) / 1e6;
+}
+
+static double best_of(unsigned int threads, int locked) {
+	double best = 0, ms;
+	unsigned int round;
+
+	for (round = 0; round < ROUNDS; round++) {
+		ms = run(threads, locked);
+		if (round == 0 || ms < best) {
+			best = ms;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char** argv) {
+	unsigned int threads;
+	unsigned int max_threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	double ws_base = 0, ws_ms, locked_ms;
+
+	if (argc > 1) {
+		max_threads = (unsigned int)atoi(argv[1]);
+	}
+	if (max_threads < 1) {
+		max_threads = 1;
+	}
+	if (max_threads > MAX_WORKERS) {
+		max_threads = MAX_WORKERS;
+	}
+
+	printf("%llu tasks of %d iterations, best of %d rounds\n",
+		   (unsigned long long)MAX_TASKS, GRAIN, ROUNDS);
+	printf("threads   ws_deque ms  speedup   locked queue ms\n");
+	for (threads = 1; threads <= max_threads; threads *= 2) {
+		ws_ms = best_of(threads, 0);
+		locked_ms = best_of(threads, 1);
+		if (threads == 1) {
+			ws_base = ws_ms;
+		}
+		printf("%7u %12.2f %8.2fx %17.2f\n", threads, ws_ms, ws_base / ws_ms,
+			   locked_ms);
+	}
+	return 0;
+}
@@ -4,6 +4,7 @@ const zcc = @import("compile_commands");
 pub fn build(b: *std.Build) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
+    const stats = b.option(bool, "stats", "Record allocator and queue instrumentation") orelse false;
 
     // --- configure the C library ---
     const boislib = b.addStaticLibrary(.{
@@ -17,10 +18,22 @@ pub fn build(b: *std.Build) void {
         .files = &.{
             "src/memory/allocator.c",
             "src/queue/circular_queue.c",
+            "src/queue/shm_queue.c",
+            "src/queue/bcast_ring.c",
+            "src/map/hash_map.c",
+            "src/deque/ws_deque.c",
+            "src/stats/stats.c",
         },
     });
+    boislib.addIncludePath(b.path("src/stats"));
+    if (stats) boislib.root_module.addCMacro("BOISLIB_STATS", "1");
     boislib.installHeader(b.path("src/memory/allocator.h"), "boislib/allocator.h");
     boislib.installHeader(b.path("src/queue/circular_queue.h"), "boislib/circular_queue.h");
+    boislib.installHeader(b.path("src/queue/shm_queue.h"), "boislib/shm_queue.h");
+    boislib.installHeader(b.path("src/queue/bcast_ring.h"), "boislib/bcast_ring.h");
+    boislib.installHeader(b.path("src/map/hash_map.h"), "boislib/hash_map.h");
+    boislib.installHeader(b.path("src/deque/ws_deque.h"), "boislib/ws_deque.h");
+    boislib.installHeader(b.path("src/stats/stats.h"), "boislib/stats.h");
 
     b.installArtifact(boislib);
     const boislib_step = b.step("boislib", "Build boislib static library");
@@ -46,14 +59,51 @@ pub fn build(b: *std.Build) void {
         .files = &.{
             "tests/allocator_tests.cpp",
             "tests/circular_queue_tests.cpp",
+            "tests/shm_queue_tests.cpp",
+            "tests/bcast_ring_tests.cpp",
+            "tests/hash_map_tests.cpp",
+            "tests/ws_deque_tests.cpp",
+            "tests/stats_tests.cpp",
         },
     });
+    if (stats) tests.root_module.addCMacro("BOISLIB_STATS", "1");
 
     b.installArtifact(tests);
     const tests_step = b.step("tests", "Build boislib test executable");
     const install_tests = b.addInstallArtifact(tests, .{});
     tests_step.dependOn(&install_tests.step);
 
+    // --- configure the example and benchmark executables ---
+    const example = b.addExecutable(.{
+        .name = "ws_thread_pool",
+        .target = target,
+        .optimize = optimize,
+        .link_libc = true,
+    });
+    example.linkLibrary(boislib);
+    example.addCSourceFiles(.{
+        .flags = &.{},
+        .files = &.{"examples/ws_thread_pool.c"},
+    });
+    const examples_step = b.step("examples", "Build boislib examples");
+    const install_example = b.addInstallArtifact(example, .{});
+    examples_step.dependOn(&install_example.step);
+
+    const bench = b.addExecutable(.{
+        .name = "ws_deque_bench",
+        .target = target,
+        .optimize = optimize,
+        .link_libc = true,
+    });
+    bench.linkLibrary(boislib);
+    bench.addCSourceFiles(.{
+        .flags = &.{},
+        .files = &.{"bench/ws_deque_bench.c"},
+    });
+    const bench_step = b.step("bench", "Build boislib benchmarks");
+    const install_bench = b.addInstallArtifact(bench, .{});
+    bench_step.dependOn(&install_bench.step);
+
     // --- step for generating compile commands ---
     var targets = std.ArrayList(*std.Build.Step.Compile).init(b.allocator);
     targets.append(boislib) catch @panic("OOM");
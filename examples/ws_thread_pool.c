@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+/* A small thread pool on top of ws_deque: every worker owns a deque, runs
+ * its own tasks newest first and steals the oldest task of a random victim
+ * when it runs dry. The work is a sum over a range that keeps splitting
+ * itself in half, handing the upper halves out as new tasks. */
+
+#include <boislib/ws_deque.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WORKERS 4
+#define DEQUE_TASKS 256
+#define RANGE_END (1ULL << 26)
+#define GRAIN 4096
+#define MAX_TASKS (RANGE_END / GRAIN)
+
+struct task {
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct worker {
+	pthread_t thread;
+	unsigned int id;
+	struct ws_deque* deque;
+	struct task* tasks;
+	size_t task_cnt;
+	uint64_t executed;
+	uint64_t stolen;
+	uint64_t sum;
+	uint32_t seed;
+};
+
+static struct worker workers[WORKERS];
+static atomic_size_t pending;
+
+static uint32_t next_random(uint32_t* seed) {
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+
+static struct task* task_new(struct worker* self, uint64_t begin, uint64_t end) {
+	struct task* task = &self->tasks[self->task_cnt++];
+	task->begin = begin;
+	task->end = end;
+	return task;
+}
+
+static void task_run(struct worker* self, const struct task* task) {
+	uint64_t begin = task->begin;
+	uint64_t end = task->end;
+	uint64_t middle, i;
+	struct task* half;
+
+	/* keep the lower half, publish the upper half */
+	while (end - begin > GRAIN) {
+		middle = begin + ((end - begin) / 2);
+		half = task_new(self, middle, end);
+		atomic_fetch_add(&pending, 1);
+		if (!ws_deque_push(self->deque, half)) {
+			task_run(self, half);
+			atomic_fetch_sub(&pending, 1);
+		}
+		end = middle;
+	}
+
+	for (i = begin; i < end; i++) {
+		self->sum += i;
+	}
+	self->executed += 1;
+}
+
+static void* worker_main(void* arg) {
+	struct worker* self = (struct worker*)arg;
+	struct worker* victim;
+	struct task* task;
+
+	while (atomic_load(&pending) > 0) {
+		task = (struct task*)ws_deque_pop(self->deque);
+		if (task == NULL) {
+			victim = &workers[next_random(&self->seed) % WORKERS];
+			if (victim == self)
+				continue;
+			if ((task = (struct task*)ws_deque_steal(victim->deque)) != NULL) {
+				self->stolen += 1;
+			}
+		}
+		if (task != NULL) {
+			task_run(self, task);
+			atomic_fetch_sub(&pending, 1);
+		}
+	}
+	return NULL;
+}
+
+int main(void) {
+	unsigned int i;
+	uint64_t sum = 0;
+	void* deque_buf;
+	size_t deque_size = ws_deque_footprint(DEQUE_TASKS);
+
+	for (i = 0; i < WORKERS; i++) {
+		workers[i].id = i;
+		deque_buf = malloc(deque_size);
+		workers[i].tasks = malloc(MAX_TASKS * sizeof(struct task));
+		workers[i].seed = 2463534242u + i;
+		if (deque_buf == NULL || workers[i].tasks == NULL) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		workers[i].deque = ws_deque_init(deque_buf, deque_size);
+	}
+
+	/* seed the first worker before anyone runs */
+	atomic_store(&pending, 1);
+	ws_deque_push(workers[0].deque, task_new(&workers[0], 0, RANGE_END));
+
+	for (i = 0; i < WORKERS; i++) {
+		pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+	}
+	for (i = 0; i < WORKERS; i++) {
+		pthread_join(workers[i].thread, NULL);
+		printf("worker %u: %llu tasks, %llu stolen\n", i,
+			   (unsigned long long)workers[i].executed,
+			   (unsigned long long)workers[i].stolen);
+		sum += workers[i].sum;
+		free(workers[i].deque);
+		free(workers[i].tasks);
+	}
+
+	printf("sum %llu, expected %llu\n", (unsigned long long)sum,
+		   (unsigned long long)(RANGE_END * (RANGE_END - 1) / 2));
+	return sum == RANGE_END * (RANGE_END - 1) / 2 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include "ws_deque.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_LINE 64
+
+/* top and bottom only grow, the slot is the counter masked by the
+ * capacity. they are signed so the owner can briefly move bottom below
+ * top while racing a thief for the last task */
+struct ws_deque {
+	_Atomic int64_t top;
+	uint8_t pad0[CACHE_LINE - sizeof(int64_t)];
+
+	_Atomic int64_t bottom;
+	int64_t mask;
+	uint8_t pad1[CACHE_LINE - (2 * sizeof(int64_t))];
+};
+
+#define SLOTS(d) ((_Atomic(void*)*)((uint8_t*)(d) + sizeof(struct ws_deque)))
+
+size_t ws_deque_footprint(size_t max_tasks) {
+	size_t capacity = 2;
+
+	while (capacity < max_tasks) {
+		capacity *= 2;
+	}
+	return sizeof(struct ws_deque) + (capacity * sizeof(_Atomic(void*)));
+}
+
+struct ws_deque* ws_deque_init(void* start, size_t buf_size) {
+	assert(start);
+	assert(((uintptr_t)start % sizeof(int64_t)) == 0);
+
+	size_t capacity = 2;
+	struct ws_deque* deque_ctx = (struct ws_deque*)start;
+
+	if (buf_size < ws_deque_footprint(capacity))
+		return NULL;
+
+	while (ws_deque_footprint(capacity * 2) <= buf_size) {
+		capacity *= 2;
+	}
+
+	atomic_init(&deque_ctx->top, 0);
+	atomic_init(&deque_ctx->bottom, 0);
+	deque_ctx->mask = (int64_t)capacity - 1;
+	return deque_ctx;
+}
+
+size_t ws_deque_capacity(struct ws_deque* deque_ctx) {
+	assert(deque_ctx);
+	return (size_t)deque_ctx->mask + 1;
+}
+
+bool ws_deque_push(struct ws_deque* deque_ctx, void* task) {
+	assert(deque_ctx);
+	assert(task);
+
+	int64_t bottom =
+		atomic_load_explicit(&deque_ctx->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&deque_ctx->top, memory_order_acquire);
+
+	if (bottom - top > deque_ctx->mask)
+		return false;
+
+	atomic_store_explicit(&SLOTS(deque_ctx)[bottom & deque_ctx->mask], task,
+						  memory_order_relaxed);
+	/* the task must be visible before a thief can see the new bottom */
+	atomic_store_explicit(&deque_ctx->bottom, bottom + 1, memory_order_release);
+	return true;
+}
+
+void* ws_deque_pop(struct ws_deque* deque_ctx) {
+	assert(deque_ctx);
+
+	void* task = NULL;
+	int64_t bottom =
+		atomic_load_explicit(&deque_ctx->bottom, memory_order_relaxed) - 1;
+	int64_t top;
+
+	/* claim the bottom task before looking at top */
+	atomic_store_explicit(&deque_ctx->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	top = atomic_load_explicit(&deque_ctx->top, memory_order_relaxed);
+
+	if (top <= bottom) {
+		task = atomic_load_explicit(
+			&SLOTS(deque_ctx)[bottom & deque_ctx->mask], memory_order_relaxed);
+		if (top == bottom) {
+			/* last task, race the thieves for it */
+			if (!atomic_compare_exchange_strong_explicit(
+					&deque_ctx->top, &top, top + 1, memory_order_seq_cst,
+					memory_order_relaxed)) {
+				task = NULL;
+			}
+			atomic_store_explicit(&deque_ctx->bottom, bottom + 1,
+								  memory_order_relaxed);
+		}
+	} else {
+		atomic_store_explicit(&deque_ctx->bottom, bottom + 1,
+							  memory_order_relaxed);
+	}
+	return task;
+}
+
+void* ws_deque_steal(struct ws_deque* deque_ctx) {
+	assert(deque_ctx);
+
+	void* task = NULL;
+	int64_t top = atomic_load_explicit(&deque_ctx->top, memory_order_acquire);
+	int64_t bottom;
+
+	atomic_thread_fence(memory_order_seq_cst);
+	bottom = atomic_load_explicit(&deque_ctx->bottom, memory_order_acquire);
+
+	if (top < bottom) {
+		task = atomic_load_explicit(&SLOTS(deque_ctx)[top & deque_ctx->mask],
+									memory_order_relaxed);
+		if (!atomic_compare_exchange_strong_explicit(
+				&deque_ctx->top, &top, top + 1, memory_order_seq_cst,
+				memory_order_relaxed)) {
+			task = NULL;
+		}
+	}
+	return task;
+}
+
+size_t ws_deque_size(struct ws_deque* deque_ctx) {
+	assert(deque_ctx);
+
+	int64_t bottom =
+		atomic_load_explicit(&deque_ctx->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&deque_ctx->top, memory_order_relaxed);
+
+	return (bottom > top) ? (size_t)(bottom - top) : 0;
+}
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#ifndef __BOISLIB_WS_DEQUE_H__
+#define __BOISLIB_WS_DEQUE_H__
+
+/* This code implements the Chase-Lev work stealing deque (with the C11
+ * memory orderings from Le, Pop, Cohen and Zappa Nardelli). The owner
+ * thread pushes and pops tasks at the bottom with plain loads and stores,
+ * only racing for the very last task, while any other thread steals from
+ * the top with a compare and swap. The deque keeps its control block at
+ * the start of the caller's buffer and never grows. */
+
+/*
+			Buffer
+	 +--------------------------------+
+	 | top (thieves)                  |
+	 +--------------------------------+  cache line
+	 | bottom, mask (owner)           |
+	 +--------------------------------+  cache line
+	 | slot 0 | slot 1 | . . . | slot |  power of two slots
+	 +--------------------------------+
+
+	 steal ->  [top ........ bottom)  <- push / pop
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief the deque lives at the start of its buffer, its layout is
+ * private to the implementation
+ */
+struct ws_deque;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief computes how many bytes a buffer must have to hold a given
+ * amount of tasks
+ *
+ * @param max_tasks: how many tasks the deque must hold
+ *
+ * @retval the buffer size in bytes
+ */
+size_t ws_deque_footprint(size_t max_tasks);
+
+/**
+ * @brief initializes a empty deque inside a continuous amount of memory
+ *
+ * @param *start: the start address of the buffer, aligned to 8 bytes
+ * @param buf_size: how many bytes this memory region has
+ *
+ * @retval the deque or null if the buffer can not hold two tasks
+ */
+struct ws_deque* ws_deque_init(void* start, size_t buf_size);
+
+/**
+ * @brief gets how many tasks the deque can hold
+ *
+ * @param *deque_ctx: the deque
+ *
+ * @retval the deque capacity
+ */
+size_t ws_deque_capacity(struct ws_deque* deque_ctx);
+
+/**
+ * @brief pushes a task at the bottom, owner thread only
+ *
+ * @param *deque_ctx: the deque
+ * @param *task: the task, must not be null
+ *
+ * @retval false if the deque is full
+ */
+bool ws_deque_push(struct ws_deque* deque_ctx, void* task);
+
+/**
+ * @brief pops the newest task from the bottom, owner thread only
+ *
+ * @param *deque_ctx: the deque
+ *
+ * @retval the task or null if the deque is empty
+ */
+void* ws_deque_pop(struct ws_deque* deque_ctx);
+
+/**
+ * @brief steals the oldest task from the top, any thread
+ *
+ * @param *deque_ctx: the deque
+ *
+ * @retval the task or null if the deque is empty or another thread won
+ * the race for it
+ */
+void* ws_deque_steal(struct ws_deque* deque_ctx);
+
+/**
+ * @brief gets how many tasks are in the deque, only a estimate while
+ * other threads are using it
+ *
+ * @param *deque_ctx: the deque
+ *
+ * @retval how many tasks are in the deque
+ */
+size_t ws_deque_size(struct ws_deque* deque_ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __BOISLIB_WS_DEQUE_H__ */
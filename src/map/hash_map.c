@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include "hash_map.h"
+#include "../memory/allocator.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define GROUP_SIZE 16
+#define BYTE_ALIGN 8
+#define CTRL_EMPTY 0x80
+#define OVERFLOW_MAX 0xFF
+
+#define H1(h) ((size_t)((h) >> 7))
+#define H2(h) ((uint8_t)((h) & 0x7F))
+#define ALIGN_UP(x, a) (((x) + ((a) - 1)) & ~((size_t)(a) - 1))
+#define SLOT(m, i) ((m)->slots + ((i) * (m)->slot_size))
+/* the table is considered full at 7/8 of its slots */
+#define MAX_ELMTS(g) ((g) * GROUP_SIZE - ((g) * GROUP_SIZE) / 8)
+
+#define SWAR_LSB 0x0101010101010101ULL
+#define SWAR_MSB 0x8080808080808080ULL
+
+static uint64_t hash_key(const void* key, size_t size);
+static size_t natural_align(size_t size);
+static size_t table_size(size_t groups, size_t slot_size);
+static size_t table_groups(size_t elmts);
+static void table_setup(struct hash_map* map_ctx, void* start, size_t groups);
+static bool table_grow(struct hash_map* map_ctx, size_t groups);
+static bool find_slot(const struct hash_map* map_ctx,
+					  const void* key,
+					  uint64_t hash,
+					  size_t* slot);
+static size_t place_slot(struct hash_map* map_ctx, uint64_t hash);
+static inline uint32_t group_match(const uint8_t* group, uint8_t tag);
+static inline uint32_t group_match_empty(const uint8_t* group);
+static inline unsigned int lowest_bit(uint32_t mask);
+
+size_t hash_map_footprint(size_t elmts, size_t key_size, size_t value_size) {
+	struct hash_map layout;
+
+	assert(key_size > 0);
+	hash_map_init_allocator(&layout, NULL, key_size, value_size);
+	return table_size(table_groups(elmts), layout.slot_size) + BYTE_ALIGN - 1;
+}
+
+void hash_map_init(struct hash_map* map_ctx,
+				   void* start,
+				   size_t buf_size,
+				   size_t key_size,
+				   size_t value_size) {
+	assert(map_ctx);
+	assert(start);
+
+	size_t groups = 1;
+	uintptr_t addr = (uintptr_t)start;
+	size_t padding = ALIGN_UP(addr, BYTE_ALIGN) - addr;
+
+	hash_map_init_allocator(map_ctx, NULL, key_size, value_size);
+
+	/* find the biggest table that fits the buffer */
+	assert(buf_size >= padding + table_size(1, map_ctx->slot_size));
+	buf_size -= padding;
+	while (table_size(groups * 2, map_ctx->slot_size) <= buf_size) {
+		groups *= 2;
+	}
+	table_setup(map_ctx, (uint8_t*)start + padding, groups);
+}
+
+void hash_map_init_allocator(struct hash_map* map_ctx,
+							 struct mem* mem_ctx,
+							 size_t key_size,
+							 size_t value_size) {
+	assert(map_ctx);
+	assert(key_size > 0);
+
+	size_t key_align = natural_align(key_size);
+	size_t value_align = natural_align(value_size);
+
+	map_ctx->ctrl = map_ctx->overflow = map_ctx->slots = NULL;
+	map_ctx->mem_ctx = mem_ctx;
+	map_ctx->block = NULL;
+	map_ctx->group_cnt = map_ctx->elmt_cnt = map_ctx->max_elmts = 0;
+	map_ctx->key_size = key_size;
+	map_ctx->value_size = value_size;
+
+	/* keep both key and value naturally aligned inside each slot */
+	map_ctx->value_offset = ALIGN_UP(key_size, value_align);
+	map_ctx->slot_size =
+		ALIGN_UP(map_ctx->value_offset + value_size,
+				 (key_align > value_align ? key_align : value_align));
+}
+
+void hash_map_deinit(struct hash_map* map_ctx) {
+	assert(map_ctx);
+
+	if (map_ctx->block != NULL) {
+		allocator_delete(map_ctx->mem_ctx, map_ctx->block);
+	}
+	map_ctx->ctrl = map_ctx->overflow = map_ctx->slots = NULL;
+	map_ctx->block = NULL;
+	map_ctx->group_cnt = map_ctx->elmt_cnt = map_ctx->max_elmts = 0;
+}
+
+bool hash_map_reserve(struct hash_map* map_ctx, size_t elmts) {
+	assert(map_ctx);
+
+	if (elmts <= map_ctx->max_elmts)
+		return true;
+
+	/* tables living in a fixed buffer can not grow */
+	if (map_ctx->mem_ctx == NULL)
+		return false;
+
+	return table_grow(map_ctx, table_groups(elmts));
+}
+
+void* hash_map_insert(struct hash_map* map_ctx,
+					  const void* key,
+					  const void* value) {
+	assert(map_ctx);
+	assert(key);
+
+	size_t slot;
+	uint8_t* value_addr;
+	uint64_t hash = hash_key(key, map_ctx->key_size);
+
+	if (!find_slot(map_ctx, key, hash, &slot)) {
+		if (map_ctx->elmt_cnt == map_ctx->max_elmts &&
+			!hash_map_reserve(map_ctx, map_ctx->elmt_cnt + 1)) {
+			return NULL;
+		}
+		slot = place_slot(map_ctx, hash);
+		memcpy(SLOT(map_ctx, slot), key, map_ctx->key_size);
+		map_ctx->elmt_cnt += 1;
+	}
+
+	value_addr = SLOT(map_ctx, slot) + map_ctx->value_offset;
+	if (value != NULL) {
+		memcpy(value_addr, value, map_ctx->value_size);
+	}
+	return value_addr;
+}
+
+void* hash_map_find(struct hash_map* map_ctx, const void* key) {
+	assert(map_ctx);
+	assert(key);
+
+	size_t slot;
+	void* ret = NULL;
+
+	if (find_slot(map_ctx, key, hash_key(key, map_ctx->key_size), &slot)) {
+		ret = SLOT(map_ctx, slot) + map_ctx->value_offset;
+	}
+	return ret;
+}
+
+bool hash_map_erase(struct hash_map* map_ctx, const void* key) {
+	assert(map_ctx);
+	assert(key);
+
+	size_t slot, group, mask, step;
+	uint64_t hash = hash_key(key, map_ctx->key_size);
+
+	if (!find_slot(map_ctx, key, hash, &slot))
+		return false;
+
+	/* undo the overflow marks left by this key on its probe path */
+	mask = map_ctx->group_cnt - 1;
+	group = H1(hash) & mask;
+	for (step = 1; group != slot / GROUP_SIZE; step++) {
+		if (map_ctx->overflow[group] < OVERFLOW_MAX) {
+			map_ctx->overflow[group] -= 1;
+		}
+		group = (group + step) & mask;
+	}
+
+	map_ctx->ctrl[slot] = CTRL_EMPTY;
+	map_ctx->elmt_cnt -= 1;
+	return true;
+}
+
+void hash_map_clear(struct hash_map* map_ctx) {
+	assert(map_ctx);
+
+	if (map_ctx->group_cnt > 0) {
+		memset(map_ctx->ctrl, CTRL_EMPTY, map_ctx->group_cnt * GROUP_SIZE);
+		memset(map_ctx->overflow, 0, map_ctx->group_cnt);
+	}
+	map_ctx->elmt_cnt = 0;
+}
+
+size_t hash_map_size(struct hash_map* map_ctx) {
+	assert(map_ctx);
+	return map_ctx->elmt_cnt;
+}
+
+static uint64_t hash_key(const void* key, size_t size) {
+	const uint8_t* ptr = (const uint8_t*)key;
+	uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+	uint64_t word;
+	size_t chunk;
+
+	while (size > 0) {
+		word = 0;
+		chunk = (size < 8 ? size : 8);
+		memcpy(&word, ptr, chunk);
+		hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 32;
+		ptr += chunk;
+		size -= chunk;
+	}
+
+	/* final avalanche, spreads the entropy over the H1 and H2 bits */
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static size_t natural_align(size_t size) {
+	size_t align = 1;
+
+	if (size == 0)
+		return align;
+
+	while (align < BYTE_ALIGN && size % (align * 2) == 0) {
+		align *= 2;
+	}
+	return align;
+}
+
+static size_t table_size(size_t groups, size_t slot_size) {
+	return ALIGN_UP(groups * (GROUP_SIZE + 1), BYTE_ALIGN) +
+		   (groups * GROUP_SIZE * slot_size);
+}
+
+static size_t table_groups(size_t elmts) {
+	size_t groups = 1;
+
+	while (MAX_ELMTS(groups) < elmts) {
+		groups *= 2;
+	}
+	return groups;
+}
+
+static void table_setup(struct hash_map* map_ctx, void* start, size_t groups) {
+	map_ctx->ctrl = (uint8_t*)start;
+	map_ctx->overflow = map_ctx->ctrl + (groups * GROUP_SIZE);
+	map_ctx->slots =
+		map_ctx->ctrl + ALIGN_UP(groups * (GROUP_SIZE + 1), BYTE_ALIGN);
+	map_ctx->group_cnt = groups;
+	map_ctx->max_elmts = MAX_ELMTS(groups);
+	hash_map_clear(map_ctx);
+}
+
+static bool table_grow(struct hash_map* map_ctx, size_t groups) {
+	size_t i, slot;
+	uintptr_t addr;
+	uint8_t* old_slot;
+	struct hash_map table = *map_ctx;
+
+	table.block = allocator_new(
+		map_ctx->mem_ctx, table_size(groups, map_ctx->slot_size) + BYTE_ALIGN - 1);
+	if (table.block == NULL)
+		return false;
+
+	addr = (uintptr_t)table.block;
+	table_setup(&table, (uint8_t*)table.block + (ALIGN_UP(addr, BYTE_ALIGN) - addr),
+				groups);
+
+	/* move every element to the new table */
+	for (i = 0; i < map_ctx->group_cnt * GROUP_SIZE; i++) {
+		if (map_ctx->ctrl[i] & CTRL_EMPTY)
+			continue;
+		old_slot = SLOT(map_ctx, i);
+		slot = place_slot(&table, hash_key(old_slot, map_ctx->key_size));
+		memcpy(SLOT(&table, slot), old_slot, map_ctx->slot_size);
+	}
+	table.elmt_cnt = map_ctx->elmt_cnt;
+
+	if (map_ctx->block != NULL) {
+		allocator_delete(map_ctx->mem_ctx, map_ctx->block);
+	}
+	*map_ctx = table;
+	return true;
+}
+
+static bool find_slot(const struct hash_map* map_ctx,
+					  const void* key,
+					  uint64_t hash,
+					  size_t* slot) {
+	size_t group, step, mask;
+	uint32_t match;
+
+	if (map_ctx->group_cnt == 0)
+		return false;
+
+	/* triangular probing visits every group once */
+	mask = map_ctx->group_cnt - 1;
+	group = H1(hash) & mask;
+	for (step = 1; step <= map_ctx->group_cnt; step++) {
+		match = group_match(map_ctx->ctrl + (group * GROUP_SIZE), H2(hash));
+		while (match != 0) {
+			*slot = (group * GROUP_SIZE) + lowest_bit(match);
+			if (memcmp(SLOT(map_ctx, *slot), key, map_ctx->key_size) == 0)
+				return true;
+			match &= match - 1;
+		}
+		/* no key ever probed past this group */
+		if (map_ctx->overflow[group] == 0)
+			return false;
+		group = (group + step) & mask;
+	}
+	return false;
+}
+
+static size_t place_slot(struct hash_map* map_ctx, uint64_t hash) {
+	size_t mask = map_ctx->group_cnt - 1;
+	size_t group = H1(hash) & mask;
+	size_t step = 1, slot;
+	uint32_t match;
+
+	/* the load factor guarantees that a empty slot exists */
+	while ((match = group_match_empty(map_ctx->ctrl + (group * GROUP_SIZE))) ==
+		   0) {
+		if (map_ctx->overflow[group] < OVERFLOW_MAX) {
+			map_ctx->overflow[group] += 1;
+		}
+		group = (group + step) & mask;
+		step++;
+	}
+
+	slot = (group * GROUP_SIZE) + lowest_bit(match);
+	map_ctx->ctrl[slot] = H2(hash);
+	return slot;
+}
+
+#if defined(__SSE2__)
+
+static inline uint32_t group_match(const uint8_t* group, uint8_t tag) {
+	__m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+	return (uint32_t)_mm_movemask_epi8(
+		_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+}
+
+static inline uint32_t group_match_empty(const uint8_t* group) {
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+
+#else
+
+/* loads 8 tags with the first tag in the lowest byte on any endianness */
+static inline uint64_t swar_load(const uint8_t* ptr) {
+	uint64_t word = 0;
+	unsigned int i;
+
+	for (i = 0; i < 8; i++) {
+		word |= (uint64_t)ptr[i] << (i * 8);
+	}
+	return word;
+}
+
+/* gathers the most significant bit of each byte into a 8 bit mask */
+static inline uint32_t swar_mask(uint64_t word) {
+	return (uint32_t)(((word & SWAR_MSB) * 0x0002040810204081ULL) >> 56);
+}
+
+/* may report false positives next to a real match, the caller always
+ * compares the keys anyway */
+static inline uint32_t swar_match(uint64_t word, uint8_t tag) {
+	word ^= SWAR_LSB * tag;
+	return swar_mask((word - SWAR_LSB) & ~word);
+}
+
+static inline uint32_t group_match(const uint8_t* group, uint8_t tag) {
+	return swar_match(swar_load(group), tag) |
+		   (swar_match(swar_load(group + 8), tag) << 8);
+}
+
+static inline uint32_t group_match_empty(const uint8_t* group) {
+	return swar_mask(swar_load(group)) | (swar_mask(swar_load(group + 8)) << 8);
+}
+
+#endif
+
+static inline unsigned int lowest_bit(uint32_t mask) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctz(mask);
+#else
+	unsigned int i = 0;
+
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#ifndef __BOISLIB_HASH_MAP_H__
+#define __BOISLIB_HASH_MAP_H__
+
+/* This code implements a open addressing hash map in the style of the
+ * swiss tables: every slot has a one byte control tag, the tags are
+ * grouped 16 at a time and a lookup compares the whole group against
+ * 7 bits of the key hash at once (SSE2 when available, SWAR otherwise)
+ * before touching any key.
+ *
+ * Deletion leaves no tombstones: every group counts how many keys had to
+ * probe past it because it was full. A lookup stops at the first group
+ * with a zero counter and a deletion decrements the counters along the
+ * probe path of the deleted key, so its slot can simply be marked empty. */
+
+/*
+			Table
+	 +--------------------------------+
+	 | ctrl: 16 tags per group        |   tag = 0x80 (empty)
+	 |  [g0: t t t ... t][g1: ...]    |   tag = 0b0hhhhhhh (used)
+	 +--------------------------------+
+	 | overflow: 1 counter per group  |
+	 +--------------------------------+
+	 | slots: 16 per group            |
+	 |  [key | value][key | value]... |
+	 +--------------------------------+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct mem;
+
+/**
+ * @brief the hash map context struct contains information about the table
+ *
+ * @param *ctrl: the control tags, 16 per group
+ * @param *overflow: the overflow counter of each group
+ * @param *slots: the key/value slots, 16 per group
+ * @param *mem_ctx: the allocator used to grow the table or null if the
+ * table lives in a fixed buffer
+ * @param *block: the block given by the allocator for the current table
+ * @param group_cnt: how many groups the table has, always a power of two
+ * @param elmt_cnt: the current amount of elements in the table
+ * @param max_elmts: the maximum amount of elements before the table is full
+ * @param key_size: the key size in bytes
+ * @param value_size: the value size in bytes
+ * @param value_offset: where the value starts inside a slot
+ * @param slot_size: the size in bytes of a slot
+ */
+struct hash_map {
+	uint8_t* ctrl;
+	uint8_t* overflow;
+	uint8_t* slots;
+	struct mem* mem_ctx;
+	void* block;
+	size_t group_cnt;
+	size_t elmt_cnt;
+	size_t max_elmts;
+	size_t key_size;
+	size_t value_size;
+	size_t value_offset;
+	size_t slot_size;
+};
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief computes how many bytes a buffer must have to hold a given
+ * amount of elements
+ *
+ * @param elmts: how many elements the table must hold
+ * @param key_size: the key size in bytes
+ * @param value_size: the value size in bytes
+ *
+ * @retval the buffer size in bytes
+ */
+size_t hash_map_footprint(size_t elmts, size_t key_size, size_t value_size);
+
+/**
+ * @brief initializes a hash map with a fixed capacity inside a continuous
+ * amount of memory
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param *start: the start address of a continuous memory location
+ * @param buf_size: how many bytes this memory region has
+ * @param key_size: the key size in bytes
+ * @param value_size: the value size in bytes
+ */
+void hash_map_init(struct hash_map* map_ctx,
+				   void* start,
+				   size_t buf_size,
+				   size_t key_size,
+				   size_t value_size);
+
+/**
+ * @brief initializes a empty hash map that grows using a allocator
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param *mem_ctx: the memory manager context struct
+ * @param key_size: the key size in bytes
+ * @param value_size: the value size in bytes
+ */
+void hash_map_init_allocator(struct hash_map* map_ctx,
+							 struct mem* mem_ctx,
+							 size_t key_size,
+							 size_t value_size);
+
+/**
+ * @brief gives the table memory back to the allocator, if any
+ *
+ * @param *map_ctx: the hash map context struct
+ */
+void hash_map_deinit(struct hash_map* map_ctx);
+
+/**
+ * @brief makes sure the table can hold a given amount of elements
+ * without growing
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param elmts: how many elements the table must hold
+ *
+ * @retval false if the table can not hold that many elements
+ */
+bool hash_map_reserve(struct hash_map* map_ctx, size_t elmts);
+
+/**
+ * @brief inserts or updates a key
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param *key: the address of the key
+ * @param *value: the address of the value to be copied or null to leave
+ * the value untouched
+ *
+ * @retval the address of the value inside the table or null if full
+ */
+void* hash_map_insert(struct hash_map* map_ctx,
+					  const void* key,
+					  const void* value);
+
+/**
+ * @brief looks up a key
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param *key: the address of the key
+ *
+ * @retval the address of the value inside the table or null if not found
+ */
+void* hash_map_find(struct hash_map* map_ctx, const void* key);
+
+/**
+ * @brief removes a key
+ *
+ * @param *map_ctx: the hash map context struct
+ * @param *key: the address of the key
+ *
+ * @retval false if the key was not found
+ */
+bool hash_map_erase(struct hash_map* map_ctx, const void* key);
+
+/**
+ * @brief removes every element, keeping the table memory
+ *
+ * @param *map_ctx: the hash map context struct
+ */
+void hash_map_clear(struct hash_map* map_ctx);
+
+/**
+ * @brief gets how many elements are in the table
+ *
+ * @param *map_ctx: the hash map context struct
+ *
+ * @retval how many elements are in the table
+ */
+size_t hash_map_size(struct hash_map* map_ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __BOISLIB_HASH_MAP_H__ */
@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #define BYTE_ALIGN 8
 #define HEADER_SIZE 2
@@ -20,11 +21,31 @@
 #define GET_SIZE(x) ((*(uint16_t*)(x)) & MAX_BLOCK_SIZE)
 #define SET_SIZE(x, s) ((*(uint16_t*)(x)) = (s))
 #define ALLOCATE(s) ((s) | 0b1)
+#define IS_MOVABLE(x) ((*(uint16_t*)(x)) & 0b10)
+#define SET_MOVABLE(x) ((*(uint16_t*)(x)) |= 0b10)
+
+/* movable blocks start with the index of their handle */
+#define HANDLE_SIZE sizeof(uint32_t)
+
+#define PERSIST_MAGIC 0x42504850 /* "BPHP" */
+#define PERSIST_HEADER(m) ((struct persist_header*)(m)->persist)
+
+/* fixed width fields so the region does not depend on the process */
+struct persist_header {
+	uint32_t magic;
+	uint32_t clean;
+	uint64_t heap_size;
+	uint64_t root;
+	uint64_t reserved;
+};
 
 static void* create_block(void* start, size_t size);
 static void* coalesce_block(const struct mem* mem_ctx, void* start);
 static inline void alloc_block(void* start);
 static inline void free_block(void* start);
+static int check_heap(const struct mem* mem_ctx);
+static struct mem_handle* block_handle(const struct mem* mem_ctx,
+									   uint8_t* block);
 
 void allocator_init(struct mem* mem_ctx, void* start, size_t size) {
 	assert(mem_ctx);
@@ -33,6 +54,11 @@ void allocator_init(struct mem* mem_ctx, void* start, size_t size) {
 
 	mem_ctx->start = start;
 	mem_ctx->end = create_block(start, size);
+	mem_ctx->handles = NULL;
+	mem_ctx->handle_cnt = 0;
+	mem_ctx->compact_offset = 0;
+	mem_ctx->persist = NULL;
+	mem_ctx->stats = NULL;
 }
 
 void* allocator_new(struct mem* mem_ctx, size_t size) {
@@ -43,6 +69,8 @@ void* allocator_new(struct mem* mem_ctx, size_t size) {
 	void* ret = NULL;
 	uint8_t* ptr = (uint8_t*)mem_ctx->start;
 	uint8_t* end = (uint8_t*)mem_ctx->end;
+	STATS_ONLY(uint64_t cycles = (mem_ctx->stats ? stats_cycles() : 0);
+			   uint64_t scanned = 0;)
 
 	/* compute the minimum block size to fit the user requested size */
 	size += METADATA_SIZE;
@@ -53,7 +81,10 @@ void* allocator_new(struct mem* mem_ctx, size_t size) {
 	/* look for a free chunk big enough to fit this size */
 	while (ptr < end && (IS_ALLOCATED(ptr) || GET_SIZE(ptr) < size)) {
 		ptr += GET_SIZE(ptr);
+		STATS_ONLY(scanned++;)
 	}
+	/* the block that fits the request was scanned too */
+	STATS_ONLY(scanned += (ptr < end);)
 
 	if (ptr < end) {
 		chunk_size = GET_SIZE(ptr);
@@ -65,6 +96,16 @@ void* allocator_new(struct mem* mem_ctx, size_t size) {
 		alloc_block(ptr);
 		ret = (void*)(ptr + HEADER_SIZE);
 	}
+
+#if defined(BOISLIB_STATS)
+	if (mem_ctx->stats != NULL) {
+		if (ret == NULL) {
+			mem_ctx->stats->new_failures += 1;
+		}
+		histogram_record(&mem_ctx->stats->new_scanned, scanned);
+		histogram_record(&mem_ctx->stats->new_cycles, stats_cycles() - cycles);
+	}
+#endif
 	return ret;
 }
 
@@ -75,6 +116,7 @@ void allocator_delete(struct mem* mem_ctx, void* addr) {
 	uint8_t* ptr = (uint8_t*)addr;
 	uint8_t* start = (uint8_t*)mem_ctx->start;
 	uint8_t* end = (uint8_t*)mem_ctx->end;
+	STATS_ONLY(uint64_t cycles = (mem_ctx->stats ? stats_cycles() : 0);)
 
 	/* make sure that the address is inside this heap */
 	if (ptr <= start || ptr >= end)
@@ -85,9 +127,17 @@ void allocator_delete(struct mem* mem_ctx, void* addr) {
 	if (!IS_ALLOCATED(ptr))
 		return;
 
+	/* a gap before the compaction resume point restarts the pass, it
+	 * could also merge with the free block the pass stopped at */
+	if ((size_t)(ptr - start) <= mem_ctx->compact_offset) {
+		mem_ctx->compact_offset = 0;
+	}
+
 	/* frees the block */
 	free_block(ptr);
 	coalesce_block(mem_ctx, ptr);
+	STATS_ONLY(if (mem_ctx->stats) histogram_record(
+				   &mem_ctx->stats->delete_cycles, stats_cycles() - cycles);)
 }
 
 size_t allocator_remaining(struct mem* mem_ctx) {
@@ -105,6 +155,267 @@ size_t allocator_remaining(struct mem* mem_ctx) {
 	return size;
 }
 
+void allocator_handles_init(struct mem* mem_ctx,
+							struct mem_handle* table,
+							size_t count) {
+	assert(mem_ctx);
+	assert(table);
+	assert(count > 0);
+
+	memset(table, 0, count * sizeof(struct mem_handle));
+	mem_ctx->handles = table;
+	mem_ctx->handle_cnt = count;
+	mem_ctx->compact_offset = 0;
+}
+
+size_t allocator_handle_new(struct mem* mem_ctx, size_t size) {
+	assert(mem_ctx);
+	assert(mem_ctx->handles);
+	assert(size > 0);
+
+	size_t i;
+	uint32_t index;
+	uint8_t* addr;
+	uint8_t* block;
+
+	/* look for a free entry in the handle table */
+	for (i = 0; i < mem_ctx->handle_cnt && mem_ctx->handles[i].offset != 0;
+		 i++) {
+	}
+	if (i == mem_ctx->handle_cnt)
+		return 0;
+
+	if ((addr = (uint8_t*)allocator_new(mem_ctx, size + HANDLE_SIZE)) == NULL)
+		return 0;
+
+	/* tag the block as movable and link it back to its handle */
+	block = addr - HEADER_SIZE;
+	SET_MOVABLE(block);
+	SET_MOVABLE(block + GET_SIZE(block) - FOOTER_SIZE);
+	index = (uint32_t)i;
+	memcpy(addr, &index, HANDLE_SIZE);
+
+	mem_ctx->handles[i].offset = (size_t)(addr - (uint8_t*)mem_ctx->start);
+	mem_ctx->handles[i].locks = 0;
+	return i + 1;
+}
+
+void allocator_handle_delete(struct mem* mem_ctx, size_t handle) {
+	assert(mem_ctx);
+	assert(handle > 0 && handle <= mem_ctx->handle_cnt);
+
+	struct mem_handle* entry = &mem_ctx->handles[handle - 1];
+
+	if (entry->offset == 0)
+		return;
+
+	allocator_delete(mem_ctx, (uint8_t*)mem_ctx->start + entry->offset);
+	entry->offset = 0;
+	entry->locks = 0;
+}
+
+void* allocator_handle_lock(struct mem* mem_ctx, size_t handle) {
+	assert(mem_ctx);
+	assert(handle > 0 && handle <= mem_ctx->handle_cnt);
+
+	struct mem_handle* entry = &mem_ctx->handles[handle - 1];
+
+	if (entry->offset == 0)
+		return NULL;
+
+	entry->locks += 1;
+	return (uint8_t*)mem_ctx->start + entry->offset + HANDLE_SIZE;
+}
+
+void allocator_handle_unlock(struct mem* mem_ctx, size_t handle) {
+	assert(mem_ctx);
+	assert(handle > 0 && handle <= mem_ctx->handle_cnt);
+
+	struct mem_handle* entry = &mem_ctx->handles[handle - 1];
+
+	if (entry->locks > 0) {
+		entry->locks -= 1;
+	}
+}
+
+size_t allocator_compact(struct mem* mem_ctx, size_t max_moves) {
+	assert(mem_ctx);
+
+	size_t gap_size, block_size, moved = 0;
+	struct mem_handle* entry;
+	uint8_t* gap;
+	uint8_t* ptr = (uint8_t*)mem_ctx->start + mem_ctx->compact_offset;
+	uint8_t* end = (uint8_t*)mem_ctx->end;
+
+	/* a pass limited by max_moves resumes where the last call stopped,
+	 * the blocks before that were already compacted */
+	mem_ctx->compact_offset = 0;
+
+	while (ptr < end) {
+		if (IS_ALLOCATED(ptr)) {
+			ptr += GET_SIZE(ptr);
+			continue;
+		}
+
+		/* measure the run of free blocks */
+		gap = ptr;
+		while (ptr < end && !IS_ALLOCATED(ptr)) {
+			ptr += GET_SIZE(ptr);
+		}
+		gap_size = (size_t)(ptr - gap);
+
+		if (max_moves != 0 && moved == max_moves) {
+			create_block(gap, gap_size);
+			mem_ctx->compact_offset = (size_t)(gap - (uint8_t*)mem_ctx->start);
+			break;
+		}
+
+		/* the block after the gap stays, merge the run and skip it */
+		entry = (ptr < end) ? block_handle(mem_ctx, ptr) : NULL;
+		if (entry == NULL || entry->locks > 0) {
+			create_block(gap, gap_size);
+			continue;
+		}
+
+		/* slide the block over the gap, the gap now follows it */
+		block_size = GET_SIZE(ptr);
+		memmove(gap, ptr, block_size);
+		entry->offset = (size_t)(gap + HEADER_SIZE - (uint8_t*)mem_ctx->start);
+		create_block(gap + block_size, gap_size);
+		ptr = gap + block_size;
+		moved++;
+	}
+
+	return moved;
+}
+
+void allocator_stats_get(struct mem* mem_ctx, struct allocator_stats* snapshot) {
+	assert(mem_ctx);
+	assert(snapshot);
+	if (mem_ctx->stats != NULL) {
+		*snapshot = *mem_ctx->stats;
+	} else {
+		memset(snapshot, 0, sizeof(*snapshot));
+	}
+}
+
+void allocator_stats_attach(struct mem* mem_ctx, struct allocator_stats* stats) {
+	assert(mem_ctx);
+	mem_ctx->stats = stats;
+	allocator_stats_reset(mem_ctx);
+}
+
+void allocator_stats_reset(struct mem* mem_ctx) {
+	assert(mem_ctx);
+	if (mem_ctx->stats != NULL) {
+		memset(mem_ctx->stats, 0, sizeof(*mem_ctx->stats));
+	}
+}
+
+int allocator_persist_open(struct mem* mem_ctx, void* start, size_t size) {
+	assert(mem_ctx);
+	assert(start);
+	assert(((uintptr_t)start % sizeof(uint64_t)) == 0);
+	assert(size >= sizeof(struct persist_header) + MIN_BLOCK_SIZE);
+
+	int ret = ALLOCATOR_FRESH;
+	struct persist_header* header = (struct persist_header*)start;
+	uint8_t* heap = (uint8_t*)start + sizeof(struct persist_header);
+	size_t heap_size = size - sizeof(struct persist_header);
+
+	mem_ctx->handles = NULL;
+	mem_ctx->handle_cnt = 0;
+	mem_ctx->compact_offset = 0;
+	mem_ctx->persist = NULL;
+	mem_ctx->stats = NULL;
+
+	/* only a region without a heap is formatted, a stored heap that does
+	 * not fit or is not consistent is left for the caller to deal with.
+	 * The stored sizes are checked before any address is made from them */
+	if (header->magic == PERSIST_MAGIC) {
+		ret = ALLOCATOR_INVALID;
+		if (header->heap_size <= heap_size &&
+			header->root < header->heap_size) {
+			mem_ctx->start = heap;
+			mem_ctx->end = heap + header->heap_size;
+			if (header->clean) {
+				ret = ALLOCATOR_RESUMED;
+			} else if (check_heap(mem_ctx)) {
+				ret = ALLOCATOR_RECOVERED;
+			}
+		}
+	}
+
+	if (ret == ALLOCATOR_INVALID) {
+		mem_ctx->start = mem_ctx->end = NULL;
+		return ret;
+	}
+
+	/* format a new one, the magic is written last */
+	if (ret == ALLOCATOR_FRESH) {
+		header->magic = 0;
+		allocator_init(mem_ctx, heap, heap_size);
+		header->heap_size = (uint8_t*)mem_ctx->end - heap;
+		header->root = 0;
+		header->reserved = 0;
+		header->magic = PERSIST_MAGIC;
+	}
+
+	/* any crash from now on leaves the heap dirty */
+	header->clean = 0;
+	mem_ctx->persist = header;
+	return ret;
+}
+
+void allocator_persist_close(struct mem* mem_ctx) {
+	assert(mem_ctx);
+
+	if (mem_ctx->persist == NULL)
+		return;
+
+	PERSIST_HEADER(mem_ctx)->clean = 1;
+}
+
+void allocator_set_root(struct mem* mem_ctx, void* addr) {
+	assert(mem_ctx);
+
+	if (mem_ctx->persist == NULL)
+		return;
+
+	PERSIST_HEADER(mem_ctx)->root = allocator_offset(mem_ctx, addr);
+}
+
+void* allocator_get_root(struct mem* mem_ctx) {
+	assert(mem_ctx);
+
+	if (mem_ctx->persist == NULL)
+		return NULL;
+
+	return allocator_address(mem_ctx, PERSIST_HEADER(mem_ctx)->root);
+}
+
+size_t allocator_offset(struct mem* mem_ctx, void* addr) {
+	assert(mem_ctx);
+
+	/* the heap starts with a block header, so no payload has offset 0 */
+	if (addr == NULL)
+		return 0;
+
+	assert((uint8_t*)addr > (uint8_t*)mem_ctx->start);
+	assert((uint8_t*)addr < (uint8_t*)mem_ctx->end);
+	return (size_t)((uint8_t*)addr - (uint8_t*)mem_ctx->start);
+}
+
+void* allocator_address(struct mem* mem_ctx, size_t offset) {
+	assert(mem_ctx);
+
+	if (offset == 0)
+		return NULL;
+
+	assert(offset < (size_t)((uint8_t*)mem_ctx->end - (uint8_t*)mem_ctx->start));
+	return (uint8_t*)mem_ctx->start + offset;
+}
+
 static void* create_block(void* start, size_t size) {
 	void* header = NULL;
 	void* footer = NULL;
@@ -186,3 +497,40 @@ static inline void free_block(void* start) {
 	SET_SIZE(header, block_size);
 	SET_SIZE(footer, block_size);
 }
+
+static int check_heap(const struct mem* mem_ctx) {
+	size_t size;
+	uint8_t* ptr = (uint8_t*)mem_ctx->start;
+	uint8_t* end = (uint8_t*)mem_ctx->end;
+
+	/* every block must fit the heap and agree with its footer */
+	while (ptr < end) {
+		size = GET_SIZE(ptr);
+		if (size < MIN_BLOCK_SIZE || size > (size_t)(end - ptr))
+			return 0;
+		if (*(uint16_t*)ptr != *(uint16_t*)(ptr + size - FOOTER_SIZE))
+			return 0;
+		ptr += size;
+	}
+	return 1;
+}
+
+static struct mem_handle* block_handle(const struct mem* mem_ctx,
+									   uint8_t* block) {
+	uint32_t index;
+	struct mem_handle* entry;
+
+	if (!IS_MOVABLE(block) || mem_ctx->handles == NULL)
+		return NULL;
+
+	/* only trust the index if the handle points back to this block */
+	memcpy(&index, block + HEADER_SIZE, HANDLE_SIZE);
+	if (index >= mem_ctx->handle_cnt)
+		return NULL;
+
+	entry = &mem_ctx->handles[index];
+	if (entry->offset != (size_t)(block + HEADER_SIZE - (uint8_t*)mem_ctx->start))
+		return NULL;
+
+	return entry;
+}
@@ -44,7 +44,65 @@
 
 */
 
+/* Blocks allocated through a handle are movable: the caller only gets a
+ * address while the handle is locked, so allocator_compact can slide the
+ * unlocked ones towards the start of the heap, merging the free blocks
+ * left behind into one big free block at the end.
+ *
+ * The block metadata only holds sizes, so a heap is position independent
+ * as long as the data inside it links to other blocks by offsets instead
+ * of addresses. The persistent mode builds on that: the region (a memory
+ * mapped file, a battery backed ram, ...) starts with a small header that
+ * records the heap size, a root object offset and a clean shutdown flag,
+ * so a restarted process can map the region again and resume its heap.
+
+		 Persistent Region
+	 +-------------------------+
+	 | magic | clean flag      |
+	 | heap size | root offset | 32 bytes
+	 +-------------------------+
+	 |                         |
+	 |          Heap           |
+	 |                         |
+	 +-------------------------+
+*/
+
+#include "stats.h"
 #include <stddef.h>
+#include <stdint.h>
+
+/* allocator_persist_open results */
+#define ALLOCATOR_FRESH 0
+#define ALLOCATOR_RESUMED 1
+#define ALLOCATOR_RECOVERED 2
+#define ALLOCATOR_INVALID -1
+
+/**
+ * @brief the allocator instrumentation, only recorded when the library is
+ * built with BOISLIB_STATS
+ *
+ * @param new_cycles: cycles spent in each allocator_new call
+ * @param delete_cycles: cycles spent in each allocator_delete call
+ * @param new_scanned: blocks scanned by each allocator_new call
+ * @param new_failures: how many allocator_new calls returned null
+ */
+struct allocator_stats {
+	struct histogram new_cycles;
+	struct histogram delete_cycles;
+	struct histogram new_scanned;
+	uint64_t new_failures;
+};
+
+/**
+ * @brief a entry of the handle table
+ *
+ * @param offset: where the handle data starts in the heap, zero if unused
+ * @param locks: how many times the handle is locked
+ */
+struct mem_handle {
+	size_t offset;
+	size_t locks;
+};
 
 /**
  * @brief the memory manager context struct contains information about the
@@ -52,10 +110,22 @@
  *
  * @param *start: The start address of a continuous amount of memory
  * @param *end: The last usable address of the memory manager
+ * @param *handles: the handle table, null if handles are not used
+ * @param handle_cnt: how many entries the handle table has
+ * @param compact_offset: where the next allocator_compact call resumes
+ * @param *persist: the persistent region header, null if the heap was not
+ * opened by allocator_persist_open
+ * @param *stats: the instrumentation given by allocator_stats_attach,
+ * null if the heap is not instrumented
  */
 struct mem {
 	void* start;
 	void* end;
+	struct mem_handle* handles;
+	size_t handle_cnt;
+	size_t compact_offset;
+	void* persist;
+	struct allocator_stats* stats;
 };
 
 #if defined(__cplusplus)
@@ -98,6 +168,161 @@ void allocator_delete(struct mem* mem_ctx, void* addr);
  */
 size_t allocator_remaining(struct mem* mem_ctx);
 
+/**
+ * @brief enables the handle API on a heap
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param *table: the handle table, provided by the caller
+ * @param count: how many entries the handle table has
+ */
+void allocator_handles_init(struct mem* mem_ctx,
+							struct mem_handle* table,
+							size_t count);
+
+/**
+ * @brief allocates a movable memory region
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param size: how many bytes to allocate
+ *
+ * @retval the handle of the region or zero if there is no memory or no
+ * free handle left
+ */
+size_t allocator_handle_new(struct mem* mem_ctx, size_t size);
+
+/**
+ * @brief frees a movable memory region, even if it is still locked
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param handle: the handle of the region
+ */
+void allocator_handle_delete(struct mem* mem_ctx, size_t handle);
+
+/**
+ * @brief pins a movable memory region and gets its address, locks nest
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param handle: the handle of the region
+ *
+ * @retval the address of the region, valid until the last unlock
+ */
+void* allocator_handle_lock(struct mem* mem_ctx, size_t handle);
+
+/**
+ * @brief unpins a movable memory region
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param handle: the handle of the region
+ */
+void allocator_handle_unlock(struct mem* mem_ctx, size_t handle);
+
+/**
+ * @brief slides unlocked movable blocks over the free blocks before
+ * them. Locked handles and blocks from allocator_new stay in place. A
+ * call stopped by max_moves is resumed by the next one, so compacting in
+ * small steps does not scan the already compacted start of the heap again
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param max_moves: how many blocks to move at most, zero for no limit
+ *
+ * @retval how many blocks were moved
+ */
+size_t allocator_compact(struct mem* mem_ctx, size_t max_moves);
+
+/**
+ * @brief gives a heap a block to record its instrumentation into, the
+ * block is cleared. Nothing is recorded unless the library is built with
+ * BOISLIB_STATS
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param *stats: the instrumentation block, provided by the caller, or
+ * null to stop recording
+ */
+void allocator_stats_attach(struct mem* mem_ctx, struct allocator_stats* stats);
+
+/**
+ * @brief copies the allocator instrumentation, all zeros when no block is
+ * attached
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param *snapshot: where to copy the instrumentation to
+ */
+void allocator_stats_get(struct mem* mem_ctx, struct allocator_stats* snapshot);
+
+/**
+ * @brief clears the allocator instrumentation
+ *
+ * @param *mem_ctx: the memory manager context struct
+ */
+void allocator_stats_reset(struct mem* mem_ctx);
+
+/**
+ * @brief opens a persistent heap, resuming the heap already stored in the
+ * region or formatting a new one if the region holds none. The heap stays
+ * marked as dirty until allocator_persist_close is called
+ *
+ * @param *mem_ctx: the allocator context struct
+ * @param *start: The start address of the region, aligned to 8 bytes
+ * @param size: how many bytes this memory region has, at least the size
+ * the stored heap was formatted with
+ *
+ * @retval ALLOCATOR_FRESH if a new heap was formatted, ALLOCATOR_RESUMED
+ * if the heap was cleanly closed, ALLOCATOR_RECOVERED if it was not but
+ * its blocks are consistent or ALLOCATOR_INVALID if the stored heap does
+ * not fit in size bytes or is corrupted. On ALLOCATOR_INVALID the region
+ * is left untouched and mem_ctx can not be used
+ */
+int allocator_persist_open(struct mem* mem_ctx, void* start, size_t size);
+
+/**
+ * @brief marks a persistent heap as cleanly closed, the caller is still
+ * in charge of flushing the region (e.g. msync) before exiting. Does
+ * nothing on a heap not opened by allocator_persist_open
+ *
+ * @param *mem_ctx: the memory manager context struct
+ */
+void allocator_persist_close(struct mem* mem_ctx);
+
+/**
+ * @brief records the root object of a persistent heap, does nothing on
+ * a heap not opened by allocator_persist_open
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param *addr: the root object address or null
+ */
+void allocator_set_root(struct mem* mem_ctx, void* addr);
+
+/**
+ * @brief gets the root object of a persistent heap
+ *
+ * @param *mem_ctx: the memory manager context struct
+ *
+ * @retval the root object address or null if there is none or the heap
+ * was not opened by allocator_persist_open
+ */
+void* allocator_get_root(struct mem* mem_ctx);
+
+/**
+ * @brief converts a address inside the heap to a position independent
+ * offset
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param *addr: the address or null
+ *
+ * @retval the offset, zero for null
+ */
+size_t allocator_offset(struct mem* mem_ctx, void* addr);
+
+/**
+ * @brief converts a offset given by allocator_offset back to a address
+ *
+ * @param *mem_ctx: the memory manager context struct
+ * @param offset: the offset
+ *
+ * @retval the address, null for a zero offset
+ */
+void* allocator_address(struct mem* mem_ctx, size_t offset);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include "bcast_ring.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+/* every counter only grows, the slot is the counter masked by the
+ * capacity. published is how many elements the consumers may read,
+ * claimed is how many slots the producer started writing (lossy mode
+ * only) and gate_cache is the last known position of the slowest
+ * consumer, so the producer rarely has to look at the cursors */
+struct bcast_ring {
+	uint64_t elmt_size;
+	uint64_t mask;
+	uint64_t consumer_cnt;
+	uint64_t lossy;
+	uint64_t data_offset;
+	uint8_t pad0[CACHE_LINE - (5 * sizeof(uint64_t))];
+
+	_Atomic uint64_t published;
+	_Atomic uint64_t claimed;
+	uint64_t gate_cache;
+	uint8_t pad1[CACHE_LINE - (3 * sizeof(uint64_t))];
+};
+
+struct bcast_cursor {
+	_Atomic uint64_t seq;
+	uint8_t pad[CACHE_LINE - sizeof(uint64_t)];
+};
+
+#define CURSOR(r, c) \
+	(&((struct bcast_cursor*)((uint8_t*)(r) + sizeof(struct bcast_ring)))[c])
+#define ELMT(r, seq) \
+	((uint8_t*)(r) + (r)->data_offset + (((seq) & (r)->mask) * (r)->elmt_size))
+
+static uint64_t slowest_cursor(struct bcast_ring* ring_ctx);
+
+size_t bcast_ring_footprint(size_t elmt_size,
+							size_t max_elmts,
+							size_t consumers) {
+	assert(elmt_size > 0);
+	assert(consumers > 0);
+	size_t capacity = 2;
+
+	while (capacity < max_elmts) {
+		capacity *= 2;
+	}
+	return sizeof(struct bcast_ring) +
+		   (consumers * sizeof(struct bcast_cursor)) + (capacity * elmt_size);
+}
+
+struct bcast_ring* bcast_ring_init(void* start,
+								   size_t buf_size,
+								   size_t elmt_size,
+								   size_t consumers,
+								   bool lossy) {
+	assert(start);
+	assert(elmt_size > 0);
+	assert(consumers > 0);
+	assert(((uintptr_t)start % sizeof(uint64_t)) == 0);
+
+	size_t i, capacity = 2;
+	struct bcast_ring* ring_ctx = (struct bcast_ring*)start;
+
+	if (buf_size < bcast_ring_footprint(elmt_size, capacity, consumers))
+		return NULL;
+
+	while (bcast_ring_footprint(elmt_size, capacity * 2, consumers) <=
+		   buf_size) {
+		capacity *= 2;
+	}
+
+	ring_ctx->elmt_size = elmt_size;
+	ring_ctx->mask = capacity - 1;
+	ring_ctx->consumer_cnt = consumers;
+	ring_ctx->lossy = lossy;
+	ring_ctx->data_offset =
+		sizeof(struct bcast_ring) + (consumers * sizeof(struct bcast_cursor));
+	atomic_init(&ring_ctx->published, 0);
+	atomic_init(&ring_ctx->claimed, 0);
+	ring_ctx->gate_cache = 0;
+	for (i = 0; i < consumers; i++) {
+		atomic_init(&CURSOR(ring_ctx, i)->seq, 0);
+	}
+	return ring_ctx;
+}
+
+size_t bcast_ring_capacity(struct bcast_ring* ring_ctx) {
+	assert(ring_ctx);
+	return (size_t)ring_ctx->mask + 1;
+}
+
+bool bcast_ring_push(struct bcast_ring* ring_ctx, const void* elmt_addr) {
+	assert(ring_ctx);
+	assert(elmt_addr);
+
+	uint64_t seq =
+		atomic_load_explicit(&ring_ctx->published, memory_order_relaxed);
+
+	if (ring_ctx->lossy) {
+		/* consumers check claimed after reading to detect overwrites */
+		atomic_store_explicit(&ring_ctx->claimed, seq + 1,
+							  memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+	} else if (seq - ring_ctx->gate_cache > ring_ctx->mask) {
+		/* only look at the cursors when the cached one says full */
+		ring_ctx->gate_cache = slowest_cursor(ring_ctx);
+		if (seq - ring_ctx->gate_cache > ring_ctx->mask)
+			return false;
+	}
+
+	memcpy(ELMT(ring_ctx, seq), elmt_addr, ring_ctx->elmt_size);
+	atomic_store_explicit(&ring_ctx->published, seq + 1, memory_order_release);
+	return true;
+}
+
+size_t bcast_ring_available(struct bcast_ring* ring_ctx, size_t consumer) {
+	assert(ring_ctx);
+	assert(consumer < ring_ctx->consumer_cnt);
+
+	uint64_t cursor =
+		atomic_load_explicit(&CURSOR(ring_ctx, consumer)->seq, memory_order_relaxed);
+	uint64_t published =
+		atomic_load_explicit(&ring_ctx->published, memory_order_acquire);
+
+	if (published - cursor > ring_ctx->mask + 1)
+		return (size_t)ring_ctx->mask + 1;
+
+	return (size_t)(published - cursor);
+}
+
+size_t bcast_ring_read(struct bcast_ring* ring_ctx,
+					   size_t consumer,
+					   void** elmts,
+					   size_t max_elmts) {
+	assert(ring_ctx);
+	assert(elmts);
+	assert(consumer < ring_ctx->consumer_cnt);
+
+	uint64_t capacity = ring_ctx->mask + 1;
+	uint64_t cursor =
+		atomic_load_explicit(&CURSOR(ring_ctx, consumer)->seq, memory_order_relaxed);
+	uint64_t published =
+		atomic_load_explicit(&ring_ctx->published, memory_order_acquire);
+	uint64_t cnt;
+
+	/* a overrun consumer skips to the oldest element still in the ring */
+	if (published - cursor > capacity) {
+		cursor = published - capacity;
+		atomic_store_explicit(&CURSOR(ring_ctx, consumer)->seq, cursor,
+							  memory_order_relaxed);
+	}
+
+	/* stop at the end of the buffer so the range is contiguous */
+	cnt = published - cursor;
+	if (cnt > capacity - (cursor & ring_ctx->mask)) {
+		cnt = capacity - (cursor & ring_ctx->mask);
+	}
+	if (cnt > max_elmts) {
+		cnt = max_elmts;
+	}
+
+	*elmts = ELMT(ring_ctx, cursor);
+	return (size_t)cnt;
+}
+
+bool bcast_ring_release(struct bcast_ring* ring_ctx,
+						size_t consumer,
+						size_t elmt_cnt) {
+	assert(ring_ctx);
+	assert(consumer < ring_ctx->consumer_cnt);
+
+	bool ret = true;
+	uint64_t capacity = ring_ctx->mask + 1;
+	uint64_t cursor =
+		atomic_load_explicit(&CURSOR(ring_ctx, consumer)->seq, memory_order_relaxed);
+	uint64_t next = cursor + elmt_cnt;
+	uint64_t claimed;
+
+	if (ring_ctx->lossy) {
+		/* the range is intact if its oldest slot was not claimed again */
+		atomic_thread_fence(memory_order_acquire);
+		claimed = atomic_load_explicit(&ring_ctx->claimed, memory_order_relaxed);
+		if (claimed > cursor + capacity) {
+			ret = false;
+			if (next < claimed - capacity) {
+				next = claimed - capacity;
+			}
+		}
+	}
+
+	atomic_store_explicit(&CURSOR(ring_ctx, consumer)->seq, next,
+						  memory_order_release);
+	return ret;
+}
+
+size_t bcast_ring_pop(struct bcast_ring* ring_ctx,
+					  size_t consumer,
+					  void* elmt_addr) {
+	assert(ring_ctx);
+	assert(elmt_addr);
+	void* src = NULL;
+
+	do {
+		if (bcast_ring_read(ring_ctx, consumer, &src, 1) == 0)
+			return 0;
+		memcpy(elmt_addr, src, ring_ctx->elmt_size);
+	} while (!bcast_ring_release(ring_ctx, consumer, 1));
+
+	return ring_ctx->elmt_size;
+}
+
+static uint64_t slowest_cursor(struct bcast_ring* ring_ctx) {
+	size_t i;
+	uint64_t cursor;
+	uint64_t slowest =
+		atomic_load_explicit(&CURSOR(ring_ctx, 0)->seq, memory_order_acquire);
+
+	for (i = 1; i < ring_ctx->consumer_cnt; i++) {
+		cursor =
+			atomic_load_explicit(&CURSOR(ring_ctx, i)->seq, memory_order_acquire);
+		if (cursor < slowest) {
+			slowest = cursor;
+		}
+	}
+	return slowest;
+}
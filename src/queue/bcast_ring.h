@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#ifndef __BOISLIB_BCAST_RING_H__
+#define __BOISLIB_BCAST_RING_H__
+
+/* This code implements a single producer broadcast ring: every element
+ * pushed is seen by every consumer, each consumer keeping its own read
+ * cursor, so one copy of a event serves all of them. By default the
+ * producer waits for the slowest consumer before reusing a slot. In lossy
+ * mode it never waits and overwrites old elements instead, a consumer
+ * that fell behind skips to the oldest element still in the ring.
+ *
+ * Consumers read in batches: bcast_ring_read gives the contiguous range
+ * of elements available to them and bcast_ring_release hands it back. */
+
+/*
+			Buffer
+	 +--------------------------------+
+	 | elmt_size, mask, consumers     |
+	 +--------------------------------+  cache line
+	 | published, claimed (producer)  |
+	 +--------------------------------+  cache line
+	 | cursor of consumer 0           |
+	 +--------------------------------+  cache line
+	 | . . .                          |
+	 +--------------------------------+  cache line
+	 | element 0 | element 1 | . . .  |  power of two elements
+	 +--------------------------------+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief the ring lives at the start of its buffer, its layout is
+ * private to the implementation
+ */
+struct bcast_ring;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief computes how many bytes a buffer must have to hold a given
+ * amount of elements
+ *
+ * @param elmt_size: the size in bytes of a element in the ring
+ * @param max_elmts: how many elements the ring must hold
+ * @param consumers: how many consumers read the ring
+ *
+ * @retval the buffer size in bytes
+ */
+size_t bcast_ring_footprint(size_t elmt_size,
+							size_t max_elmts,
+							size_t consumers);
+
+/**
+ * @brief initializes a empty ring inside a continuous amount of memory
+ *
+ * @param *start: the start address of the buffer, aligned to 8 bytes
+ * @param buf_size: how many bytes this memory region has
+ * @param elmt_size: the size in bytes of a element in the ring
+ * @param consumers: how many consumers read the ring
+ * @param lossy: overwrite the oldest elements instead of waiting for the
+ * slowest consumer
+ *
+ * @retval the ring or null if the buffer can not hold two elements
+ */
+struct bcast_ring* bcast_ring_init(void* start,
+								   size_t buf_size,
+								   size_t elmt_size,
+								   size_t consumers,
+								   bool lossy);
+
+/**
+ * @brief gets how many elements the ring can hold
+ *
+ * @param *ring_ctx: the ring
+ *
+ * @retval the ring capacity
+ */
+size_t bcast_ring_capacity(struct bcast_ring* ring_ctx);
+
+/**
+ * @brief copies a given element into the ring, producer thread only
+ *
+ * @param *ring_ctx: the ring
+ * @param *elmt_addr: the start address of the element to be inserted
+ *
+ * @retval false if the slowest consumer still has to read the slot
+ */
+bool bcast_ring_push(struct bcast_ring* ring_ctx, const void* elmt_addr);
+
+/**
+ * @brief gets how many elements a consumer still has to read
+ *
+ * @param *ring_ctx: the ring
+ * @param consumer: the consumer index
+ *
+ * @retval how many elements are available
+ */
+size_t bcast_ring_available(struct bcast_ring* ring_ctx, size_t consumer);
+
+/**
+ * @brief gets the next contiguous range of elements of a consumer
+ *
+ * @param *ring_ctx: the ring
+ * @param consumer: the consumer index
+ * @param **elmts: where to store the address of the first element
+ * @param max_elmts: the maximum amount of elements to read
+ *
+ * @retval how many elements the range has, zero if there is none
+ */
+size_t bcast_ring_read(struct bcast_ring* ring_ctx,
+					   size_t consumer,
+					   void** elmts,
+					   size_t max_elmts);
+
+/**
+ * @brief hands a range given by bcast_ring_read back to the producer
+ *
+ * @param *ring_ctx: the ring
+ * @param consumer: the consumer index
+ * @param elmt_cnt: how many elements of the range were read
+ *
+ * @retval false if, in lossy mode, the producer overwrote the range while
+ * it was being read
+ */
+bool bcast_ring_release(struct bcast_ring* ring_ctx,
+						size_t consumer,
+						size_t elmt_cnt);
+
+/**
+ * @brief copies the next element of a consumer out of the ring
+ *
+ * @param *ring_ctx: the ring
+ * @param consumer: the consumer index
+ * @param *elmt_addr: where to copy the element to
+ *
+ * @retval how many bytes were copied
+ */
+size_t bcast_ring_pop(struct bcast_ring* ring_ctx,
+					  size_t consumer,
+					  void* elmt_addr);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __BOISLIB_BCAST_RING_H__ */
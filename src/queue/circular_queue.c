@@ -24,6 +24,7 @@ void queue_init(struct queue* queue_ctx,
 	queue_ctx->max_elmts = buf_size / elmt_size;
 	queue_ctx->elmt_size = elmt_size;
 	queue_ctx->head = queue_ctx->tail = queue_ctx->elmt_cnt = 0;
+	queue_ctx->stats = NULL;
 }
 
 void* queue_alloc(struct queue* queue_ctx) {
@@ -32,11 +33,18 @@ void* queue_alloc(struct queue* queue_ctx) {
 
 	if (queue_full(queue_ctx)) {
 		ret = NULL;
+		STATS_ONLY(if (queue_ctx->stats) queue_ctx->stats->full_rejects += 1;)
 	} else {
 		ret = (uint8_t*)queue_ctx->start +
 			  (queue_ctx->tail * queue_ctx->elmt_size);
 		queue_ctx->tail = (queue_ctx->tail + 1) % queue_ctx->max_elmts;
 		queue_ctx->elmt_cnt += 1;
+#if defined(BOISLIB_STATS)
+		if (queue_ctx->stats != NULL &&
+			queue_ctx->elmt_cnt > queue_ctx->stats->high_water) {
+			queue_ctx->stats->high_water = queue_ctx->elmt_cnt;
+		}
+#endif
 	}
 	return ret;
 }
@@ -46,22 +54,30 @@ size_t queue_push(struct queue* queue_ctx, void* elmt_addr) {
 	assert(elmt_addr);
 	size_t ret = 0;
 	void* dest = NULL;
+	STATS_ONLY(uint64_t cycles = (queue_ctx->stats ? stats_cycles() : 0);)
 
 	if ((dest = queue_alloc(queue_ctx)) != NULL) {
 		memcpy(dest, elmt_addr, queue_ctx->elmt_size);
 		ret = queue_ctx->elmt_size;
 	}
+	STATS_ONLY(if (queue_ctx->stats) histogram_record(
+				   &queue_ctx->stats->push_cycles, stats_cycles() - cycles);)
 	return ret;
 }
 
 void* queue_pop(struct queue* queue_ctx) {
 	assert(queue_ctx);
 	void* ret = NULL;
+	STATS_ONLY(uint64_t cycles = (queue_ctx->stats ? stats_cycles() : 0);)
 
 	if ((ret = queue_peek(queue_ctx)) != NULL) {
 		queue_ctx->head = (queue_ctx->head + 1) % queue_ctx->max_elmts;
 		queue_ctx->elmt_cnt -= 1;
+	} else {
+		STATS_ONLY(if (queue_ctx->stats) queue_ctx->stats->empty_rejects += 1;)
 	}
+	STATS_ONLY(if (queue_ctx->stats) histogram_record(
+				   &queue_ctx->stats->pop_cycles, stats_cycles() - cycles);)
 	return ret;
 }
 
@@ -98,3 +114,26 @@ size_t inline queue_remaining(struct queue* queue_ctx) {
 	assert(queue_ctx);
 	return queue_ctx->max_elmts - queue_ctx->elmt_cnt;
 }
+
+void queue_stats_get(struct queue* queue_ctx, struct queue_stats* snapshot) {
+	assert(queue_ctx);
+	assert(snapshot);
+	if (queue_ctx->stats != NULL) {
+		*snapshot = *queue_ctx->stats;
+	} else {
+		memset(snapshot, 0, sizeof(*snapshot));
+	}
+}
+
+void queue_stats_attach(struct queue* queue_ctx, struct queue_stats* stats) {
+	assert(queue_ctx);
+	queue_ctx->stats = stats;
+	queue_stats_reset(queue_ctx);
+}
+
+void queue_stats_reset(struct queue* queue_ctx) {
+	assert(queue_ctx);
+	if (queue_ctx->stats != NULL) {
+		memset(queue_ctx->stats, 0, sizeof(*queue_ctx->stats));
+	}
+}
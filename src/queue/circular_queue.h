@@ -7,8 +7,28 @@
 #ifndef __BOISLIB_CIRCULAR_QUEUE_H__
 #define __BOISLIB_CIRCULAR_QUEUE_H__
 
+#include "stats.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief the queue instrumentation, only recorded when the library is
+ * built with BOISLIB_STATS
+ *
+ * @param push_cycles: cycles spent in each queue_push call
+ * @param pop_cycles: cycles spent in each queue_pop call
+ * @param high_water: the most elements the queue ever held
+ * @param full_rejects: how many allocations failed on a full queue
+ * @param empty_rejects: how many pops failed on a empty queue
+ */
+struct queue_stats {
+	struct histogram push_cycles;
+	struct histogram pop_cycles;
+	uint64_t high_water;
+	uint64_t full_rejects;
+	uint64_t empty_rejects;
+};
 
 /**
  * @brief the queue context struct contains information about the queue
@@ -20,6 +40,8 @@
  * @param elmt_cnt: the current amount of elements in the queue
  * @param max_elmts: the maximum amount of elements the queue can hold
  * @param *end: the last usable address of the queue
+ * @param *stats: the instrumentation given by queue_stats_attach, null
+ * if the queue is not instrumented
  */
 struct queue {
 	void* start;
@@ -28,6 +50,7 @@ struct queue {
 	size_t elmt_size;
 	size_t elmt_cnt;
 	size_t max_elmts;
+	struct queue_stats* stats;
 };
 
 #if defined(__cplusplus)
@@ -108,6 +131,33 @@ void* queue_pop(struct queue* queue_ctx);
  */
 size_t queue_remaining(struct queue* queue_ctx);
 
+/**
+ * @brief gives a queue a block to record its instrumentation into, the
+ * block is cleared. Nothing is recorded unless the library is built with
+ * BOISLIB_STATS
+ *
+ * @param *queue_ctx: the queue context struct
+ * @param *stats: the instrumentation block, provided by the caller, or
+ * null to stop recording
+ */
+void queue_stats_attach(struct queue* queue_ctx, struct queue_stats* stats);
+
+/**
+ * @brief copies the queue instrumentation, all zeros when no block is
+ * attached
+ *
+ * @param *queue_ctx: the queue context struct
+ * @param *snapshot: where to copy the instrumentation to
+ */
+void queue_stats_get(struct queue* queue_ctx, struct queue_stats* snapshot);
+
+/**
+ * @brief clears the queue instrumentation
+ *
+ * @param *queue_ctx: the queue context struct
+ */
+void queue_stats_reset(struct queue* queue_ctx);
+
 #if defined(__cplusplus)
 }
 #endif
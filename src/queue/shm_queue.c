@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include "shm_queue.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+#define SHM_QUEUE_MAGIC 0x42534D51 /* "BSMQ" */
+
+/* head and tail only grow, the slot is the counter modulo max_elmts.
+ * every field has a fixed width so both sides agree on the layout and
+ * each counter sits alone in its cache line, next to the cached copy of
+ * the other side's counter used to avoid touching the shared line */
+struct shm_queue {
+	_Atomic uint32_t magic;
+	uint32_t reserved;
+	uint64_t elmt_size;
+	uint64_t max_elmts;
+	uint64_t data_offset;
+	uint8_t pad0[CACHE_LINE - 32];
+
+	_Atomic uint64_t tail;
+	uint64_t head_cache;
+	uint8_t pad1[CACHE_LINE - 16];
+
+	_Atomic uint64_t head;
+	uint64_t tail_cache;
+	uint8_t pad2[CACHE_LINE - 16];
+};
+
+#define ELMT(q, cnt) \
+	((uint8_t*)(q) + (q)->data_offset + (((cnt) % (q)->max_elmts) * (q)->elmt_size))
+
+size_t shm_queue_footprint(size_t elmt_size, size_t max_elmts) {
+	assert(elmt_size > 0);
+	return sizeof(struct shm_queue) + (elmt_size * max_elmts);
+}
+
+struct shm_queue* shm_queue_init(void* start,
+								 size_t elmt_size,
+								 size_t buf_size) {
+	assert(start);
+	assert(elmt_size > 0);
+	assert(((uintptr_t)start % sizeof(uint64_t)) == 0);
+
+	struct shm_queue* queue_ctx = (struct shm_queue*)start;
+
+	/* the processes can only share the counters if they are lock free */
+	assert(atomic_is_lock_free(&queue_ctx->tail));
+
+	if (buf_size < shm_queue_footprint(elmt_size, 1))
+		return NULL;
+
+	atomic_store_explicit(&queue_ctx->magic, 0, memory_order_relaxed);
+	queue_ctx->reserved = 0;
+	queue_ctx->elmt_size = elmt_size;
+	queue_ctx->max_elmts = (buf_size - sizeof(struct shm_queue)) / elmt_size;
+	queue_ctx->data_offset = sizeof(struct shm_queue);
+	atomic_store_explicit(&queue_ctx->tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&queue_ctx->head, 0, memory_order_relaxed);
+	queue_ctx->head_cache = queue_ctx->tail_cache = 0;
+
+	/* publish the queue only after the control block is written */
+	atomic_store_explicit(&queue_ctx->magic, SHM_QUEUE_MAGIC,
+						  memory_order_release);
+	return queue_ctx;
+}
+
+struct shm_queue* shm_queue_attach(void* start, size_t buf_size) {
+	assert(start);
+
+	struct shm_queue* queue_ctx = (struct shm_queue*)start;
+
+	if (buf_size < sizeof(struct shm_queue))
+		return NULL;
+
+	if (atomic_load_explicit(&queue_ctx->magic, memory_order_acquire) !=
+		SHM_QUEUE_MAGIC)
+		return NULL;
+
+	/* the control block was written by another process, make sure every
+	 * element it points to is inside this mapping. The footprint check is
+	 * done as a division so a huge elmt_size can not overflow it */
+	if (queue_ctx->data_offset != sizeof(struct shm_queue) ||
+		queue_ctx->elmt_size == 0 || queue_ctx->max_elmts == 0 ||
+		queue_ctx->max_elmts >
+			(buf_size - sizeof(struct shm_queue)) / queue_ctx->elmt_size)
+		return NULL;
+
+	return queue_ctx;
+}
+
+bool shm_queue_empty(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	return atomic_load_explicit(&queue_ctx->head, memory_order_relaxed) ==
+		   atomic_load_explicit(&queue_ctx->tail, memory_order_acquire);
+}
+
+bool shm_queue_full(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	return shm_queue_remaining(queue_ctx) == 0;
+}
+
+void* shm_queue_alloc(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	uint64_t tail = atomic_load_explicit(&queue_ctx->tail, memory_order_relaxed);
+
+	/* only look at the consumer's line when the cached head says full */
+	if (tail - queue_ctx->head_cache == queue_ctx->max_elmts) {
+		queue_ctx->head_cache =
+			atomic_load_explicit(&queue_ctx->head, memory_order_acquire);
+		if (tail - queue_ctx->head_cache == queue_ctx->max_elmts)
+			return NULL;
+	}
+	return ELMT(queue_ctx, tail);
+}
+
+void shm_queue_commit(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	uint64_t tail = atomic_load_explicit(&queue_ctx->tail, memory_order_relaxed);
+	atomic_store_explicit(&queue_ctx->tail, tail + 1, memory_order_release);
+}
+
+size_t shm_queue_push(struct shm_queue* queue_ctx, const void* elmt_addr) {
+	assert(queue_ctx);
+	assert(elmt_addr);
+	size_t ret = 0;
+	void* dest = NULL;
+
+	if ((dest = shm_queue_alloc(queue_ctx)) != NULL) {
+		memcpy(dest, elmt_addr, queue_ctx->elmt_size);
+		shm_queue_commit(queue_ctx);
+		ret = queue_ctx->elmt_size;
+	}
+	return ret;
+}
+
+void* shm_queue_peek(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	uint64_t head = atomic_load_explicit(&queue_ctx->head, memory_order_relaxed);
+
+	/* only look at the producer's line when the cached tail says empty */
+	if (head == queue_ctx->tail_cache) {
+		queue_ctx->tail_cache =
+			atomic_load_explicit(&queue_ctx->tail, memory_order_acquire);
+		if (head == queue_ctx->tail_cache)
+			return NULL;
+	}
+	return ELMT(queue_ctx, head);
+}
+
+void shm_queue_release(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	uint64_t head = atomic_load_explicit(&queue_ctx->head, memory_order_relaxed);
+	atomic_store_explicit(&queue_ctx->head, head + 1, memory_order_release);
+}
+
+size_t shm_queue_pop(struct shm_queue* queue_ctx, void* elmt_addr) {
+	assert(queue_ctx);
+	assert(elmt_addr);
+	size_t ret = 0;
+	void* src = NULL;
+
+	if ((src = shm_queue_peek(queue_ctx)) != NULL) {
+		memcpy(elmt_addr, src, queue_ctx->elmt_size);
+		shm_queue_release(queue_ctx);
+		ret = queue_ctx->elmt_size;
+	}
+	return ret;
+}
+
+size_t shm_queue_remaining(struct shm_queue* queue_ctx) {
+	assert(queue_ctx);
+	uint64_t head = atomic_load_explicit(&queue_ctx->head, memory_order_acquire);
+	uint64_t tail = atomic_load_explicit(&queue_ctx->tail, memory_order_acquire);
+	return queue_ctx->max_elmts - (size_t)(tail - head);
+}
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#ifndef __BOISLIB_SHM_QUEUE_H__
+#define __BOISLIB_SHM_QUEUE_H__
+
+/* This code implements a single producer single consumer FIFO that keeps
+ * its control block and its elements together in the same memory region.
+ * Nothing in the region is a absolute address, so the region can be a
+ * shared mapping (memfd, shm_open, ...) mapped at different addresses by
+ * the producer and the consumer processes. */
+
+/*
+			Region
+	 +--------------------------------+
+	 | elmt_size, max_elmts, offset   |
+	 +--------------------------------+  cache line
+	 | tail (producer writes)         |
+	 +--------------------------------+  cache line
+	 | head (consumer writes)         |
+	 +--------------------------------+  cache line
+	 | element 0 | element 1 | . . .  |
+	 +--------------------------------+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief the shared queue lives at the start of its own memory region,
+ * its layout is private to the implementation
+ */
+struct shm_queue;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief computes how many bytes a region must have to hold a given
+ * amount of elements
+ *
+ * @param elmt_size: the size in bytes of a element in the queue
+ * @param max_elmts: how many elements the queue must hold
+ *
+ * @retval the region size in bytes
+ */
+size_t shm_queue_footprint(size_t elmt_size, size_t max_elmts);
+
+/**
+ * @brief formats a memory region as a empty queue, done once by only one
+ * of the processes sharing the region
+ *
+ * @param *start: the start address of the region, aligned to 8 bytes
+ * @param elmt_size: the size in bytes of a element in the queue
+ * @param buf_size: how many bytes this memory region has
+ *
+ * @retval the queue or null if the region can not hold a single element
+ */
+struct shm_queue* shm_queue_init(void* start,
+								 size_t elmt_size,
+								 size_t buf_size);
+
+/**
+ * @brief attaches to a region already formatted by shm_queue_init
+ *
+ * @param *start: the start address of the region in this process
+ * @param buf_size: how many bytes are mapped at start in this process
+ *
+ * @retval the queue or null if the region does not hold a queue or the
+ * queue it holds does not fit in buf_size bytes
+ */
+struct shm_queue* shm_queue_attach(void* start, size_t buf_size);
+
+/**
+ * @brief checks if a queue is empty
+ *
+ * @param *queue_ctx: the queue
+ *
+ * @retval false or true
+ */
+bool shm_queue_empty(struct shm_queue* queue_ctx);
+
+/**
+ * @brief checks if a queue is full
+ *
+ * @param *queue_ctx: the queue
+ *
+ * @retval false or true
+ */
+bool shm_queue_full(struct shm_queue* queue_ctx);
+
+/**
+ * @brief gets the next free element for the producer to fill in place,
+ * it is only seen by the consumer after shm_queue_commit
+ *
+ * @param *queue_ctx: the queue
+ *
+ * @retval the start address of the element or null if the queue is full
+ */
+void* shm_queue_alloc(struct shm_queue* queue_ctx);
+
+/**
+ * @brief publishes the element given by the last shm_queue_alloc
+ *
+ * @param *queue_ctx: the queue
+ */
+void shm_queue_commit(struct shm_queue* queue_ctx);
+
+/**
+ * @brief copies a given element into the queue
+ *
+ * @param *queue_ctx: the queue
+ * @param *elmt_addr: the start address of the element to be inserted
+ *
+ * @retval how many bytes were copied
+ */
+size_t shm_queue_push(struct shm_queue* queue_ctx, const void* elmt_addr);
+
+/**
+ * @brief peeks the next element to be read from the queue, it stays
+ * valid until shm_queue_release
+ *
+ * @param *queue_ctx: the queue
+ *
+ * @retval the element address or null if there is no element to read
+ */
+void* shm_queue_peek(struct shm_queue* queue_ctx);
+
+/**
+ * @brief gives the element returned by the last shm_queue_peek back to
+ * the producer
+ *
+ * @param *queue_ctx: the queue
+ */
+void shm_queue_release(struct shm_queue* queue_ctx);
+
+/**
+ * @brief copies the next element out of the queue and removes it
+ *
+ * @param *queue_ctx: the queue
+ * @param *elmt_addr: where to copy the element to
+ *
+ * @retval how many bytes were copied
+ */
+size_t shm_queue_pop(struct shm_queue* queue_ctx, void* elmt_addr);
+
+/**
+ * @brief gets how many free elements are left in the queue
+ *
+ * @param *queue_ctx: the queue
+ *
+ * @retval how many free elements are left in the queue
+ */
+size_t shm_queue_remaining(struct shm_queue* queue_ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __BOISLIB_SHM_QUEUE_H__ */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include "stats.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+uint64_t stats_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#elif defined(__aarch64__)
+	uint64_t cycles;
+	__asm__ volatile("mrs %0, cntvct_el0" : "=r"(cycles));
+	return cycles;
+#else
+	return 0;
+#endif
+}
+
+void histogram_reset(struct histogram* hist) {
+	assert(hist);
+	memset(hist, 0, sizeof(*hist));
+}
+
+void histogram_record(struct histogram* hist, uint64_t value) {
+	assert(hist);
+	unsigned int bucket = 0;
+	uint64_t bits = value;
+
+	while (bits != 0 && bucket < STATS_BUCKETS - 1) {
+		bits >>= 1;
+		bucket++;
+	}
+
+	hist->buckets[bucket] += 1;
+	hist->count += 1;
+	hist->sum += value;
+	if (value > hist->max) {
+		hist->max = value;
+	}
+}
+
+uint64_t histogram_percentile(const struct histogram* hist,
+							  unsigned int percent) {
+	assert(hist);
+	assert(percent <= 100);
+	unsigned int bucket;
+	uint64_t upper;
+	uint64_t seen = 0;
+	uint64_t rank = (hist->count * percent + 99) / 100;
+
+	if (hist->count == 0)
+		return 0;
+
+	for (bucket = 0; bucket < STATS_BUCKETS - 1; bucket++) {
+		seen += hist->buckets[bucket];
+		if (seen >= rank && seen > 0)
+			break;
+	}
+
+	/* the last bucket is open ended */
+	if (bucket == STATS_BUCKETS - 1)
+		return hist->max;
+
+	upper = (bucket == 0) ? 0 : (((uint64_t)1 << bucket) - 1);
+	return (upper < hist->max) ? upper : hist->max;
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#ifndef __BOISLIB_STATS_H__
+#define __BOISLIB_STATS_H__
+
+/* This code implements the instrumentation shared by the other libraries:
+ * a cheap cycle counter and log scale histograms. The libraries only
+ * record into them when built with BOISLIB_STATS defined, otherwise the
+ * hooks compile to nothing. The context structs only hold a pointer to a
+ * stats block attached by the caller, so their layout does not depend on
+ * how the library was built. */
+
+/*
+		Histogram
+	 +--------+--------+--------+--------+       +--------+
+	 |   0    |   1    |  2..3  |  4..7  | . . . | 2^30.. |
+	 +--------+--------+--------+--------+       +--------+
+	 bucket 0  bucket 1 bucket 2 bucket 3         bucket 31
+*/
+
+#include <stdint.h>
+
+#define STATS_BUCKETS 32
+
+#if defined(BOISLIB_STATS)
+#define STATS_ONLY(...) __VA_ARGS__
+#else
+#define STATS_ONLY(...)
+#endif
+
+/**
+ * @brief a log scale histogram, bucket i counts the values that need
+ * exactly i bits
+ *
+ * @param buckets: how many values fell in each bucket
+ * @param count: how many values were recorded
+ * @param sum: the sum of every recorded value
+ * @param max: the biggest recorded value
+ */
+struct histogram {
+	uint64_t buckets[STATS_BUCKETS];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+};
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief reads the cpu cycle counter (time stamp counter on x86, virtual
+ * counter on aarch64)
+ *
+ * @retval the current cycle count or zero if the platform has none
+ */
+uint64_t stats_cycles(void);
+
+/**
+ * @brief empties a histogram
+ *
+ * @param *hist: the histogram
+ */
+void histogram_reset(struct histogram* hist);
+
+/**
+ * @brief records a value into a histogram
+ *
+ * @param *hist: the histogram
+ * @param value: the value to be recorded
+ */
+void histogram_record(struct histogram* hist, uint64_t value);
+
+/**
+ * @brief estimates a percentile of the recorded values
+ *
+ * @param *hist: the histogram
+ * @param percent: the percentile, from 0 to 100
+ *
+ * @retval the upper bound of the bucket holding the percentile
+ */
+uint64_t histogram_percentile(const struct histogram* hist,
+							  unsigned int percent);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __BOISLIB_STATS_H__ */
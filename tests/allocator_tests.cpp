@@ -7,6 +7,11 @@
 #include <gtest/gtest.h>
 #include <cstdint>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "boislib/allocator.h"
 
 constexpr unsigned int header_size = 2;
@@ -18,6 +23,9 @@ constexpr unsigned int tiny_buf_size = min_block_size * 3;
 constexpr unsigned int small_buf_size = 256;
 constexpr unsigned int medium_buf_size = max_block_size;
 constexpr unsigned int big_buf_size = (max_block_size * 2) + 2;
+constexpr unsigned int persist_header_size = 32;
+constexpr unsigned int handle_cnt = 8;
+constexpr unsigned int handle_data_size = 20;
 
 class MemMgrInitTests : public testing::Test {
 	protected:
@@ -88,6 +96,58 @@ class MemMgrRemainingTests : public testing::Test {
 	void TearDown() override { delete[] tiny_buf; }
 };
 
+class MemMgrPersistTests : public testing::Test {
+	protected:
+	struct mem mem;
+	uint64_t* region;
+
+	void SetUp() override {
+		region = new uint64_t[small_buf_size / sizeof(uint64_t)];
+		memset(region, 0, small_buf_size);
+	}
+
+	void TearDown() override { delete[] region; }
+};
+
+class MemMgrHandleTests : public testing::Test {
+	protected:
+	struct mem mem;
+	struct mem_handle table[handle_cnt];
+	size_t handles[handle_cnt];
+	uint8_t* small_buf;
+
+	void SetUp() override {
+		small_buf = new uint8_t[small_buf_size];
+		allocator_init(&mem, (void*)small_buf, small_buf_size);
+		allocator_handles_init(&mem, table, handle_cnt);
+	}
+
+	void TearDown() override { delete[] small_buf; }
+
+	/* fills the heap with handles and frees every other one */
+	void fragment() {
+		size_t i;
+		for (i = 0; i < handle_cnt; i++) {
+			handles[i] = allocator_handle_new(&mem, handle_data_size);
+			ASSERT_NE(handles[i], 0);
+			uint8_t* data = (uint8_t*)allocator_handle_lock(&mem, handles[i]);
+			memset(data, (int)i, handle_data_size);
+			allocator_handle_unlock(&mem, handles[i]);
+		}
+		for (i = 0; i < handle_cnt; i += 2) {
+			allocator_handle_delete(&mem, handles[i]);
+		}
+	}
+
+	void expect_data(size_t i) {
+		uint8_t* data = (uint8_t*)allocator_handle_lock(&mem, handles[i]);
+		for (size_t j = 0; j < handle_data_size; j++) {
+			ASSERT_EQ(data[j], i);
+		}
+		allocator_handle_unlock(&mem, handles[i]);
+	}
+};
+
 TEST_F(MemMgrInitTests, SmallMemory) {
 	allocator_init(&mem, (void*)small_buf, small_buf_size);
 	ASSERT_EQ(mem.start, (void*)small_buf);
@@ -213,3 +273,253 @@ TEST_F(MemMgrRemainingTests, MiddleBlockAllocated) {
 	ASSERT_EQ(remaining_size,
 			  (min_block_size * 2 - (header_size + footer_size) * 2));
 }
+
+TEST_F(MemMgrPersistTests, Fresh) {
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_FRESH);
+	ASSERT_EQ(mem.start, (uint8_t*)region + persist_header_size);
+	ASSERT_EQ(mem.end, (uint8_t*)region + small_buf_size);
+	ASSERT_EQ(allocator_get_root(&mem), nullptr);
+	ASSERT_EQ(allocator_remaining(&mem),
+			  small_buf_size - persist_header_size - header_size - footer_size);
+}
+
+TEST_F(MemMgrPersistTests, Resumed) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	uint8_t* data = (uint8_t*)allocator_new(&mem, sizeof(uint32_t));
+	data[0] = 0xCA;
+	data[1] = 0xFE;
+	allocator_set_root(&mem, data);
+	size_t remaining = allocator_remaining(&mem);
+	allocator_persist_close(&mem);
+
+	struct mem resumed;
+	ASSERT_EQ(allocator_persist_open(&resumed, region, small_buf_size),
+			  ALLOCATOR_RESUMED);
+	ASSERT_EQ(allocator_get_root(&resumed), data);
+	ASSERT_EQ(((uint8_t*)allocator_get_root(&resumed))[0], 0xCA);
+	ASSERT_EQ(((uint8_t*)allocator_get_root(&resumed))[1], 0xFE);
+	ASSERT_EQ(allocator_remaining(&resumed), remaining);
+}
+
+TEST_F(MemMgrPersistTests, Recovered) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	void* data = allocator_new(&mem, sizeof(uint32_t));
+	allocator_set_root(&mem, data);
+	/* never closed */
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_RECOVERED);
+	ASSERT_EQ(allocator_get_root(&mem), data);
+}
+
+TEST_F(MemMgrPersistTests, Corrupted) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	void* data = allocator_new(&mem, sizeof(uint32_t));
+	allocator_set_root(&mem, data);
+	*(uint16_t*)mem.start = 0xFFF0;
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_INVALID);
+	/* the corrupted heap is kept for the caller to inspect */
+	ASSERT_EQ(*(uint16_t*)((uint8_t*)region + persist_header_size), 0xFFF0);
+	*(uint16_t*)((uint8_t*)region + persist_header_size) =
+		min_block_size | 0b1;
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_RECOVERED);
+	ASSERT_EQ(allocator_get_root(&mem), data);
+}
+
+TEST_F(MemMgrPersistTests, SizeMismatch) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	uint8_t* data = (uint8_t*)allocator_new(&mem, sizeof(uint32_t));
+	data[0] = 0xCA;
+	allocator_set_root(&mem, data);
+	allocator_persist_close(&mem);
+
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size / 2),
+			  ALLOCATOR_INVALID);
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_RESUMED);
+	ASSERT_EQ(allocator_get_root(&mem), data);
+	ASSERT_EQ(((uint8_t*)allocator_get_root(&mem))[0], 0xCA);
+}
+
+TEST_F(MemMgrPersistTests, NotPersistent) {
+	allocator_init(&mem, region, small_buf_size);
+	ASSERT_EQ(mem.persist, nullptr);
+	void* data = allocator_new(&mem, sizeof(uint32_t));
+	allocator_set_root(&mem, data);
+	allocator_persist_close(&mem);
+	ASSERT_EQ(allocator_get_root(&mem), nullptr);
+}
+
+TEST_F(MemMgrPersistTests, HugeStoredSize) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	allocator_persist_close(&mem);
+	region[1] = UINT64_MAX;
+	ASSERT_EQ(allocator_persist_open(&mem, region, small_buf_size),
+			  ALLOCATOR_INVALID);
+	ASSERT_EQ(mem.persist, nullptr);
+	ASSERT_EQ(mem.end, nullptr);
+}
+
+TEST_F(MemMgrPersistTests, Offsets) {
+	allocator_persist_open(&mem, region, small_buf_size);
+	void* data = allocator_new(&mem, sizeof(uint32_t));
+	ASSERT_EQ(allocator_offset(&mem, NULL), 0);
+	ASSERT_EQ(allocator_address(&mem, 0), nullptr);
+	ASSERT_EQ(allocator_offset(&mem, data), header_size);
+	ASSERT_EQ(allocator_address(&mem, allocator_offset(&mem, data)), data);
+}
+
+#if defined(__linux__)
+struct persist_node {
+	uint64_t next;
+	uint64_t value;
+};
+
+TEST(MemMgrPersistFileTests, RemapAtOtherAddress) {
+	constexpr size_t file_size = 4096;
+	constexpr uint64_t nodes = 10;
+	char path[] = "/tmp/boislib_heap_XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	unlink(path);
+	ASSERT_EQ(ftruncate(fd, file_size), 0);
+
+	struct mem mem;
+	void* region =
+		mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ASSERT_NE(region, MAP_FAILED);
+	ASSERT_EQ(allocator_persist_open(&mem, region, file_size),
+			  ALLOCATOR_FRESH);
+
+	/* a linked list using offsets as links, payloads are not 8 byte
+	 * aligned so the nodes are copied in and out */
+	struct persist_node node;
+	uint64_t head = 0;
+	for (uint64_t i = 0; i < nodes; i++) {
+		void* addr = allocator_new(&mem, sizeof(struct persist_node));
+		ASSERT_NE(addr, nullptr);
+		node.value = i;
+		node.next = head;
+		memcpy(addr, &node, sizeof(node));
+		head = allocator_offset(&mem, addr);
+	}
+	allocator_set_root(&mem, allocator_address(&mem, head));
+	allocator_persist_close(&mem);
+	ASSERT_EQ(msync(region, file_size, MS_SYNC), 0);
+
+	/* keep the old mapping so the new one lands somewhere else */
+	void* remapped =
+		mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ASSERT_NE(remapped, MAP_FAILED);
+	ASSERT_NE(remapped, region);
+	munmap(region, file_size);
+
+	struct mem resumed;
+	ASSERT_EQ(allocator_persist_open(&resumed, remapped, file_size),
+			  ALLOCATOR_RESUMED);
+	void* addr = allocator_get_root(&resumed);
+	for (uint64_t i = nodes; i > 0; i--) {
+		ASSERT_NE(addr, nullptr);
+		memcpy(&node, addr, sizeof(node));
+		ASSERT_EQ(node.value, i - 1);
+		addr = allocator_address(&resumed, node.next);
+	}
+	ASSERT_EQ(addr, nullptr);
+
+	munmap(remapped, file_size);
+	close(fd);
+}
+#endif
+
+TEST_F(MemMgrHandleTests, NewLockDelete) {
+	size_t handle = allocator_handle_new(&mem, 8);
+	ASSERT_EQ(handle, 1);
+	void* addr = allocator_handle_lock(&mem, handle);
+	ASSERT_NE(addr, nullptr);
+	ASSERT_EQ(table[0].locks, 1);
+	allocator_handle_unlock(&mem, handle);
+	ASSERT_EQ(table[0].locks, 0);
+	allocator_handle_delete(&mem, handle);
+	ASSERT_EQ(allocator_handle_lock(&mem, handle), nullptr);
+	ASSERT_EQ(allocator_remaining(&mem),
+			  small_buf_size - header_size - footer_size);
+}
+
+TEST_F(MemMgrHandleTests, OutOfHandles) {
+	for (size_t i = 0; i < handle_cnt; i++) {
+		ASSERT_NE(allocator_handle_new(&mem, 1), 0);
+	}
+	ASSERT_EQ(allocator_handle_new(&mem, 1), 0);
+}
+
+TEST_F(MemMgrHandleTests, CompactRebuildsOneFreeBlock) {
+	fragment();
+	size_t remaining = allocator_remaining(&mem);
+	ASSERT_EQ(allocator_new(&mem, remaining / 2), nullptr);
+
+	ASSERT_EQ(allocator_compact(&mem, 0), handle_cnt / 2);
+	ASSERT_EQ(allocator_compact(&mem, 0), 0);
+	for (size_t i = 1; i < handle_cnt; i += 2) {
+		expect_data(i);
+	}
+	/* the free blocks became one, saving their metadata */
+	ASSERT_EQ(allocator_remaining(&mem),
+			  remaining + (handle_cnt / 2 - 1) * (header_size + footer_size));
+	ASSERT_NE(allocator_new(&mem, allocator_remaining(&mem)), nullptr);
+}
+
+TEST_F(MemMgrHandleTests, CompactIsIncremental) {
+	fragment();
+	ASSERT_EQ(allocator_compact(&mem, 1), 1);
+	expect_data(1);
+	ASSERT_EQ(allocator_compact(&mem, 1), 1);
+	ASSERT_EQ(allocator_compact(&mem, 0), handle_cnt / 2 - 2);
+	for (size_t i = 1; i < handle_cnt; i += 2) {
+		expect_data(i);
+	}
+}
+
+TEST_F(MemMgrHandleTests, CompactResumes) {
+	fragment();
+	ASSERT_EQ(mem.compact_offset, 0);
+	ASSERT_EQ(allocator_compact(&mem, 1), 1);
+	size_t first = mem.compact_offset;
+	ASSERT_GT(first, 0);
+	ASSERT_EQ(allocator_compact(&mem, 1), 1);
+	ASSERT_GT(mem.compact_offset, first);
+	/* a block freed before the resume point restarts the pass */
+	allocator_handle_delete(&mem, handles[1]);
+	ASSERT_EQ(mem.compact_offset, 0);
+	ASSERT_EQ(allocator_compact(&mem, 0), handle_cnt / 2 - 1);
+	ASSERT_EQ(mem.compact_offset, 0);
+	for (size_t i = 3; i < handle_cnt; i += 2) {
+		expect_data(i);
+	}
+}
+
+TEST_F(MemMgrHandleTests, LockedBlocksStay) {
+	fragment();
+	void* locked = allocator_handle_lock(&mem, handles[3]);
+	ASSERT_EQ(allocator_compact(&mem, 0), 3);
+	ASSERT_EQ(allocator_handle_lock(&mem, handles[3]), locked);
+	allocator_handle_unlock(&mem, handles[3]);
+	allocator_handle_unlock(&mem, handles[3]);
+	for (size_t i = 1; i < handle_cnt; i += 2) {
+		expect_data(i);
+	}
+	ASSERT_EQ(allocator_compact(&mem, 0), 3);
+}
+
+TEST_F(MemMgrHandleTests, PlainBlocksStay) {
+	size_t fst = allocator_handle_new(&mem, handle_data_size);
+	void* plain = allocator_new(&mem, handle_data_size);
+	size_t sec = allocator_handle_new(&mem, handle_data_size);
+	allocator_handle_delete(&mem, fst);
+	ASSERT_EQ(allocator_compact(&mem, 0), 0);
+	allocator_delete(&mem, plain);
+	ASSERT_EQ(allocator_compact(&mem, 0), 1);
+	ASSERT_EQ(allocator_handle_lock(&mem, sec),
+			  (uint8_t*)mem.start + header_size + sizeof(uint32_t));
+}
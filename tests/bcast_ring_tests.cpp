@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "boislib/bcast_ring.h"
+
+constexpr unsigned int ring_elmts = 8;
+constexpr unsigned int ring_consumers = 3;
+
+class BcastRingTests : public testing::Test {
+	protected:
+	struct bcast_ring* ring;
+	struct bcast_ring* lossy_ring;
+	uint64_t* buf;
+	uint64_t* lossy_buf;
+	size_t buf_size;
+
+	void SetUp() override {
+		buf_size =
+			bcast_ring_footprint(sizeof(uint64_t), ring_elmts, ring_consumers);
+		buf = new uint64_t[buf_size / sizeof(uint64_t)];
+		lossy_buf = new uint64_t[buf_size / sizeof(uint64_t)];
+		ring = bcast_ring_init(buf, buf_size, sizeof(uint64_t), ring_consumers,
+							   false);
+		lossy_ring = bcast_ring_init(lossy_buf, buf_size, sizeof(uint64_t),
+									 ring_consumers, true);
+	}
+
+	void TearDown() override {
+		delete[] buf;
+		delete[] lossy_buf;
+	}
+};
+
+TEST_F(BcastRingTests, Init) {
+	ASSERT_EQ((void*)ring, (void*)buf);
+	ASSERT_EQ(bcast_ring_capacity(ring), ring_elmts);
+	ASSERT_EQ(bcast_ring_available(ring, 0), 0);
+	ASSERT_EQ(bcast_ring_init(buf, sizeof(uint64_t), sizeof(uint64_t), 1,
+							  false),
+			  nullptr);
+}
+
+TEST_F(BcastRingTests, EveryConsumerSeesEveryElement) {
+	uint64_t in = 42, out;
+	ASSERT_TRUE(bcast_ring_push(ring, &in));
+	for (unsigned int c = 0; c < ring_consumers; c++) {
+		ASSERT_EQ(bcast_ring_available(ring, c), 1);
+		ASSERT_EQ(bcast_ring_pop(ring, c, &out), sizeof(uint64_t));
+		ASSERT_EQ(out, in);
+		ASSERT_EQ(bcast_ring_pop(ring, c, &out), 0);
+	}
+}
+
+TEST_F(BcastRingTests, GatedBySlowestConsumer) {
+	uint64_t i, out;
+	for (i = 0; i < ring_elmts; i++) {
+		ASSERT_TRUE(bcast_ring_push(ring, &i));
+	}
+	ASSERT_FALSE(bcast_ring_push(ring, &i));
+	ASSERT_EQ(bcast_ring_pop(ring, 0, &out), sizeof(uint64_t));
+	ASSERT_EQ(bcast_ring_pop(ring, 1, &out), sizeof(uint64_t));
+	ASSERT_FALSE(bcast_ring_push(ring, &i));
+	ASSERT_EQ(bcast_ring_pop(ring, 2, &out), sizeof(uint64_t));
+	ASSERT_TRUE(bcast_ring_push(ring, &i));
+}
+
+TEST_F(BcastRingTests, BatchReadStopsAtTheEnd) {
+	uint64_t i, out;
+	void* elmts;
+	for (i = 0; i < ring_elmts - 2; i++) {
+		bcast_ring_push(ring, &i);
+		for (unsigned int c = 0; c < ring_consumers; c++) {
+			bcast_ring_pop(ring, c, &out);
+		}
+	}
+	for (i = 0; i < 4; i++) {
+		ASSERT_TRUE(bcast_ring_push(ring, &i));
+	}
+	ASSERT_EQ(bcast_ring_read(ring, 0, &elmts, 16), 2);
+	ASSERT_EQ(((uint64_t*)elmts)[0], 0);
+	ASSERT_EQ(((uint64_t*)elmts)[1], 1);
+	ASSERT_TRUE(bcast_ring_release(ring, 0, 2));
+	ASSERT_EQ(bcast_ring_read(ring, 0, &elmts, 1), 1);
+	ASSERT_EQ(elmts, (void*)((uint8_t*)buf + buf_size -
+							 (ring_elmts * sizeof(uint64_t))));
+	ASSERT_EQ(bcast_ring_read(ring, 0, &elmts, 16), 2);
+	ASSERT_EQ(((uint64_t*)elmts)[1], 3);
+	ASSERT_TRUE(bcast_ring_release(ring, 0, 2));
+	ASSERT_EQ(bcast_ring_available(ring, 0), 0);
+	ASSERT_EQ(bcast_ring_available(ring, 1), 4);
+}
+
+TEST_F(BcastRingTests, LossyOverwrites) {
+	uint64_t i, out;
+	void* elmts;
+	for (i = 0; i < ring_elmts * 2 + 3; i++) {
+		ASSERT_TRUE(bcast_ring_push(lossy_ring, &i));
+	}
+	ASSERT_EQ(bcast_ring_available(lossy_ring, 0), ring_elmts);
+	ASSERT_EQ(bcast_ring_pop(lossy_ring, 0, &out), sizeof(uint64_t));
+	ASSERT_EQ(out, ring_elmts + 3);
+
+	/* a range overwritten while being read is reported */
+	ASSERT_EQ(bcast_ring_read(lossy_ring, 1, &elmts, 2), 2);
+	ASSERT_EQ(*(uint64_t*)elmts, ring_elmts + 3);
+	bcast_ring_push(lossy_ring, &i);
+	ASSERT_FALSE(bcast_ring_release(lossy_ring, 1, 2));
+	ASSERT_EQ(bcast_ring_pop(lossy_ring, 1, &out), sizeof(uint64_t));
+	ASSERT_EQ(out, ring_elmts + 5);
+}
+
+TEST_F(BcastRingTests, ConcurrentConsumers) {
+	constexpr uint64_t total = 100000;
+	std::vector<std::thread> consumers;
+	std::vector<uint64_t> sums(ring_consumers, 0);
+
+	for (unsigned int c = 0; c < ring_consumers; c++) {
+		consumers.emplace_back([this, c, &sums]() {
+			uint64_t expected = 0;
+			void* elmts;
+			while (expected < total) {
+				size_t cnt = bcast_ring_read(ring, c, &elmts, 4);
+				if (cnt == 0)
+					std::this_thread::yield();
+				for (size_t i = 0; i < cnt; i++) {
+					EXPECT_EQ(((uint64_t*)elmts)[i], expected);
+					sums[c] += ((uint64_t*)elmts)[i];
+					expected++;
+				}
+				bcast_ring_release(ring, c, cnt);
+			}
+		});
+	}
+
+	for (uint64_t i = 0; i < total;) {
+		if (bcast_ring_push(ring, &i))
+			i++;
+		else
+			std::this_thread::yield();
+	}
+	for (auto& thread : consumers) {
+		thread.join();
+	}
+	for (unsigned int c = 0; c < ring_consumers; c++) {
+		ASSERT_EQ(sums[c], total * (total - 1) / 2);
+	}
+}
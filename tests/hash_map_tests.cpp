@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "boislib/allocator.h"
+#include "boislib/hash_map.h"
+
+constexpr unsigned int group_size = 16;
+constexpr unsigned int map_buf_size = 1024;
+constexpr unsigned int heap_size = (0xFFFF ^ 0b111);
+
+class HashMapTests : public testing::Test {
+	protected:
+	struct hash_map map;
+	uint8_t* buf;
+
+	void SetUp() override {
+		buf = new uint8_t[map_buf_size];
+		hash_map_init(&map, buf, map_buf_size, sizeof(uint32_t),
+					  sizeof(uint32_t));
+	}
+
+	void TearDown() override { delete[] buf; }
+};
+
+class HashMapAllocatorTests : public testing::Test {
+	protected:
+	struct mem mem;
+	struct hash_map map;
+	uint8_t* heap;
+
+	void SetUp() override {
+		heap = new uint8_t[heap_size];
+		allocator_init(&mem, heap, heap_size);
+		hash_map_init_allocator(&map, &mem, sizeof(uint64_t),
+								sizeof(uint32_t));
+	}
+
+	void TearDown() override { delete[] heap; }
+};
+
+TEST_F(HashMapTests, Init) {
+	ASSERT_EQ(map.slot_size, 2 * sizeof(uint32_t));
+	ASSERT_EQ(map.value_offset, sizeof(uint32_t));
+	ASSERT_EQ(map.elmt_cnt, 0);
+	ASSERT_GT(map.group_cnt, 0);
+	ASSERT_EQ(map.group_cnt & (map.group_cnt - 1), 0);
+	ASSERT_EQ(map.max_elmts, map.group_cnt * group_size * 7 / 8);
+	ASSERT_LE(hash_map_footprint(map.max_elmts, sizeof(uint32_t),
+								 sizeof(uint32_t)),
+			  map_buf_size);
+}
+
+TEST_F(HashMapTests, InsertFind) {
+	uint32_t key = 42, value = 7;
+	void* ret = hash_map_insert(&map, &key, &value);
+	ASSERT_NE(ret, nullptr);
+	ASSERT_EQ(*(uint32_t*)ret, value);
+	ASSERT_EQ(hash_map_find(&map, &key), ret);
+	key = 43;
+	ASSERT_EQ(hash_map_find(&map, &key), nullptr);
+	ASSERT_EQ(hash_map_size(&map), 1);
+}
+
+TEST_F(HashMapTests, Update) {
+	uint32_t key = 42, value = 7;
+	void* fst = hash_map_insert(&map, &key, &value);
+	value = 8;
+	void* sec = hash_map_insert(&map, &key, &value);
+	ASSERT_EQ(fst, sec);
+	ASSERT_EQ(*(uint32_t*)sec, value);
+	ASSERT_EQ(hash_map_size(&map), 1);
+}
+
+TEST_F(HashMapTests, Full) {
+	uint32_t key;
+	for (key = 0; key < map.max_elmts; key++) {
+		ASSERT_NE(hash_map_insert(&map, &key, &key), nullptr);
+	}
+	ASSERT_EQ(hash_map_insert(&map, &key, &key), nullptr);
+	ASSERT_FALSE(hash_map_reserve(&map, map.max_elmts + 1));
+	for (key = 0; key < map.max_elmts; key++) {
+		ASSERT_EQ(*(uint32_t*)hash_map_find(&map, &key), key);
+	}
+}
+
+TEST_F(HashMapTests, EraseLeavesNoTombstones) {
+	uint32_t key, round;
+	size_t i;
+	for (round = 0; round < 8; round++) {
+		for (key = 0; key < map.max_elmts; key++) {
+			uint32_t value = key + round;
+			ASSERT_NE(hash_map_insert(&map, &key, &value), nullptr);
+		}
+		for (key = 0; key < map.max_elmts; key += 2) {
+			ASSERT_TRUE(hash_map_erase(&map, &key));
+			ASSERT_FALSE(hash_map_erase(&map, &key));
+		}
+		for (key = 0; key < map.max_elmts; key++) {
+			void* ret = hash_map_find(&map, &key);
+			if (key % 2 == 0) {
+				ASSERT_EQ(ret, nullptr);
+			} else {
+				ASSERT_EQ(*(uint32_t*)ret, key + round);
+			}
+		}
+		for (key = 1; key < map.max_elmts; key += 2) {
+			ASSERT_TRUE(hash_map_erase(&map, &key));
+		}
+		ASSERT_EQ(hash_map_size(&map), 0);
+		/* every probe path was undone */
+		for (i = 0; i < map.group_cnt; i++) {
+			ASSERT_EQ(map.overflow[i], 0);
+		}
+	}
+}
+
+TEST_F(HashMapTests, Clear) {
+	uint32_t key = 1;
+	hash_map_insert(&map, &key, &key);
+	hash_map_clear(&map);
+	ASSERT_EQ(hash_map_size(&map), 0);
+	ASSERT_EQ(hash_map_find(&map, &key), nullptr);
+}
+
+TEST_F(HashMapAllocatorTests, Grow) {
+	uint64_t key;
+	uint32_t value;
+	ASSERT_EQ(map.group_cnt, 0);
+	key = 0;
+	ASSERT_EQ(hash_map_find(&map, &key), nullptr);
+	for (key = 0; key < 500; key++) {
+		value = (uint32_t)key * 3;
+		ASSERT_NE(hash_map_insert(&map, &key, &value), nullptr);
+	}
+	ASSERT_EQ(hash_map_size(&map), 500);
+	for (key = 0; key < 500; key++) {
+		ASSERT_EQ(*(uint32_t*)hash_map_find(&map, &key), key * 3);
+	}
+}
+
+TEST_F(HashMapAllocatorTests, Reserve) {
+	size_t remaining = allocator_remaining(&mem);
+	ASSERT_TRUE(hash_map_reserve(&map, 100));
+	ASSERT_GE(map.max_elmts, 100);
+	ASSERT_EQ((uintptr_t)map.slots % 8, 0);
+	ASSERT_FALSE(hash_map_reserve(&map, heap_size));
+	hash_map_deinit(&map);
+	ASSERT_EQ(allocator_remaining(&mem), remaining);
+}
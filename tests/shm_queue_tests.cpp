@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "boislib/shm_queue.h"
+
+constexpr unsigned int shm_elmts = 16;
+constexpr unsigned int shm_elmt_size = sizeof(uint64_t);
+
+class ShmQueueTests : public testing::Test {
+	protected:
+	struct shm_queue* queue;
+	size_t buf_size;
+	uint64_t* buf;
+
+	void SetUp() override {
+		buf_size = shm_queue_footprint(shm_elmt_size, shm_elmts);
+		buf = new uint64_t[buf_size / sizeof(uint64_t)];
+		queue = shm_queue_init(buf, shm_elmt_size, buf_size);
+	}
+
+	void TearDown() override { delete[] buf; }
+};
+
+TEST_F(ShmQueueTests, Init) {
+	ASSERT_EQ((void*)queue, (void*)buf);
+	ASSERT_EQ(shm_queue_attach(buf, buf_size), queue);
+	ASSERT_TRUE(shm_queue_empty(queue));
+	ASSERT_EQ(shm_queue_remaining(queue), shm_elmts);
+	ASSERT_EQ(shm_queue_init(buf, shm_elmt_size, shm_elmt_size), nullptr);
+}
+
+TEST_F(ShmQueueTests, AttachUnformatted) {
+	uint64_t region[32] = {0};
+	ASSERT_EQ(shm_queue_attach(region, sizeof(region)), nullptr);
+}
+
+TEST_F(ShmQueueTests, AttachTooSmall) {
+	ASSERT_EQ(shm_queue_attach(buf, buf_size - shm_elmt_size), nullptr);
+	ASSERT_EQ(shm_queue_attach(buf, 0), nullptr);
+}
+
+TEST_F(ShmQueueTests, AttachBadControlBlock) {
+	/* the same layout as the private control block header */
+	uint64_t* fields = buf + 1;
+	fields[0] = 0;
+	ASSERT_EQ(shm_queue_attach(buf, buf_size), nullptr);
+	fields[0] = shm_elmt_size;
+	fields[1] = (uint64_t)-1;
+	ASSERT_EQ(shm_queue_attach(buf, buf_size), nullptr);
+	fields[1] = shm_elmts;
+	fields[2] += shm_elmt_size;
+	ASSERT_EQ(shm_queue_attach(buf, buf_size), nullptr);
+	fields[2] -= shm_elmt_size;
+	ASSERT_EQ(shm_queue_attach(buf, buf_size), queue);
+}
+
+TEST_F(ShmQueueTests, PushPop) {
+	uint64_t in = 10, out = 0;
+	ASSERT_EQ(shm_queue_push(queue, &in), shm_elmt_size);
+	ASSERT_FALSE(shm_queue_empty(queue));
+	ASSERT_EQ(*(uint64_t*)shm_queue_peek(queue), in);
+	ASSERT_EQ(shm_queue_pop(queue, &out), shm_elmt_size);
+	ASSERT_EQ(out, in);
+	ASSERT_EQ(shm_queue_pop(queue, &out), 0);
+}
+
+TEST_F(ShmQueueTests, Full) {
+	uint64_t i;
+	for (i = 0; i < shm_elmts; i++) {
+		ASSERT_EQ(shm_queue_push(queue, &i), shm_elmt_size);
+	}
+	ASSERT_TRUE(shm_queue_full(queue));
+	ASSERT_EQ(shm_queue_alloc(queue), nullptr);
+	ASSERT_EQ(shm_queue_pop(queue, &i), shm_elmt_size);
+	ASSERT_EQ(i, 0);
+	ASSERT_NE(shm_queue_alloc(queue), nullptr);
+}
+
+TEST_F(ShmQueueTests, Wraps) {
+	uint64_t i, out;
+	for (i = 0; i < shm_elmts * 3; i++) {
+		ASSERT_EQ(shm_queue_push(queue, &i), shm_elmt_size);
+		ASSERT_EQ(shm_queue_pop(queue, &out), shm_elmt_size);
+		ASSERT_EQ(out, i);
+	}
+}
+
+#if defined(__linux__)
+TEST(ShmQueueMappingTests, TwoProcesses) {
+	constexpr uint64_t records = 100000;
+	size_t size = shm_queue_footprint(shm_elmt_size, shm_elmts);
+	int fd = memfd_create("boislib_shm_queue", 0);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(ftruncate(fd, size), 0);
+
+	void* consumer_map =
+		mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ASSERT_NE(consumer_map, MAP_FAILED);
+	struct shm_queue* consumer =
+		shm_queue_init(consumer_map, shm_elmt_size, size);
+	ASSERT_NE(consumer, nullptr);
+
+	pid_t pid = fork();
+	ASSERT_GE(pid, 0);
+	if (pid == 0) {
+		/* the producer maps the region on its own and only attaches */
+		void* producer_map =
+			mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (producer_map == MAP_FAILED || producer_map == consumer_map)
+			_exit(1);
+		struct shm_queue* producer = shm_queue_attach(producer_map, size);
+		if (producer == nullptr)
+			_exit(2);
+		for (uint64_t i = 0; i < records;) {
+			if (shm_queue_push(producer, &i) != 0)
+				i++;
+			else
+				sched_yield();
+		}
+		_exit(0);
+	}
+
+	uint64_t expected = 0, out;
+	int status = 0;
+	while (expected < records) {
+		if (shm_queue_pop(consumer, &out) != 0) {
+			EXPECT_EQ(out, expected);
+			if (out != expected)
+				break;
+			expected++;
+		} else if (pid == 0) {
+			/* the producer exited and its records are drained */
+			break;
+		} else if (waitpid(pid, &status, WNOHANG) == pid) {
+			pid = 0;
+		} else {
+			sched_yield();
+		}
+	}
+	EXPECT_EQ(expected, records);
+
+	if (pid != 0) {
+		/* a producer blocked on a full queue never exits by itself */
+		if (expected < records)
+			kill(pid, SIGKILL);
+		ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	}
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+
+	munmap(consumer_map, size);
+	close(fd);
+}
+#endif
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "boislib/allocator.h"
+#include "boislib/circular_queue.h"
+#include "boislib/stats.h"
+
+constexpr unsigned int stats_heap_size = 256;
+constexpr unsigned int stats_queue_size = 4 * sizeof(int);
+
+class HistogramTests : public testing::Test {
+	protected:
+	struct histogram hist;
+
+	void SetUp() override { histogram_reset(&hist); }
+};
+
+class StatsTests : public testing::Test {
+	protected:
+	struct mem mem;
+	struct queue queue;
+	struct allocator_stats mem_block;
+	struct queue_stats queue_block;
+	uint8_t heap[stats_heap_size];
+	uint8_t buf[stats_queue_size];
+
+	void SetUp() override {
+		allocator_init(&mem, heap, stats_heap_size);
+		queue_init(&queue, buf, sizeof(int), stats_queue_size);
+		allocator_stats_attach(&mem, &mem_block);
+		queue_stats_attach(&queue, &queue_block);
+	}
+};
+
+TEST_F(HistogramTests, Buckets) {
+	histogram_record(&hist, 0);
+	histogram_record(&hist, 1);
+	histogram_record(&hist, 2);
+	histogram_record(&hist, 3);
+	histogram_record(&hist, 1000);
+	histogram_record(&hist, UINT64_MAX);
+	ASSERT_EQ(hist.buckets[0], 1);
+	ASSERT_EQ(hist.buckets[1], 1);
+	ASSERT_EQ(hist.buckets[2], 2);
+	ASSERT_EQ(hist.buckets[10], 1);
+	ASSERT_EQ(hist.buckets[STATS_BUCKETS - 1], 1);
+	ASSERT_EQ(hist.count, 6);
+	ASSERT_EQ(hist.max, UINT64_MAX);
+}
+
+TEST_F(HistogramTests, Percentile) {
+	ASSERT_EQ(histogram_percentile(&hist, 50), 0);
+	for (uint64_t i = 0; i < 90; i++) {
+		histogram_record(&hist, 5);
+	}
+	for (uint64_t i = 0; i < 10; i++) {
+		histogram_record(&hist, 100);
+	}
+	ASSERT_EQ(histogram_percentile(&hist, 50), 7);
+	ASSERT_EQ(histogram_percentile(&hist, 90), 7);
+	ASSERT_EQ(histogram_percentile(&hist, 99), 100);
+	ASSERT_EQ(histogram_percentile(&hist, 100), 100);
+}
+
+TEST_F(StatsTests, Detached) {
+	struct allocator_stats mem_stats;
+	struct queue_stats queue_stats;
+	int var = 10;
+	allocator_stats_attach(&mem, NULL);
+	queue_stats_attach(&queue, NULL);
+	allocator_new(&mem, 8);
+	queue_push(&queue, &var);
+	allocator_stats_get(&mem, &mem_stats);
+	queue_stats_get(&queue, &queue_stats);
+	ASSERT_EQ(mem_stats.new_cycles.count, 0);
+	ASSERT_EQ(queue_stats.push_cycles.count, 0);
+	/* the detached blocks are left as they were */
+	ASSERT_EQ(mem_block.new_cycles.count, 0);
+	ASSERT_EQ(queue_block.push_cycles.count, 0);
+}
+
+#if defined(BOISLIB_STATS)
+TEST_F(StatsTests, Allocator) {
+	struct allocator_stats stats;
+	void* fst = allocator_new(&mem, 8);
+	allocator_new(&mem, 8);
+	allocator_delete(&mem, fst);
+	allocator_new(&mem, stats_heap_size);
+	allocator_stats_get(&mem, &stats);
+	ASSERT_EQ(stats.new_cycles.count, 3);
+	ASSERT_EQ(stats.delete_cycles.count, 1);
+	ASSERT_EQ(stats.new_scanned.count, 3);
+	/* the first allocation scans one block, the other two scan more */
+	ASSERT_EQ(stats.new_scanned.buckets[0], 0);
+	ASSERT_EQ(stats.new_scanned.buckets[1], 1);
+	ASSERT_EQ(stats.new_scanned.max, 3);
+	ASSERT_EQ(stats.new_failures, 1);
+
+	allocator_stats_reset(&mem);
+	allocator_stats_get(&mem, &stats);
+	ASSERT_EQ(stats.new_cycles.count, 0);
+	ASSERT_EQ(stats.new_failures, 0);
+}
+
+TEST_F(StatsTests, Queue) {
+	struct queue_stats stats;
+	int var = 10;
+	queue_pop(&queue);
+	for (unsigned int i = 0; i < stats_queue_size / sizeof(int) + 1; i++) {
+		queue_push(&queue, &var);
+	}
+	queue_pop(&queue);
+	queue_stats_get(&queue, &stats);
+	ASSERT_EQ(stats.push_cycles.count, stats_queue_size / sizeof(int) + 1);
+	ASSERT_EQ(stats.pop_cycles.count, 2);
+	ASSERT_EQ(stats.high_water, stats_queue_size / sizeof(int));
+	ASSERT_EQ(stats.full_rejects, 1);
+	ASSERT_EQ(stats.empty_rejects, 1);
+}
+#else
+TEST_F(StatsTests, Disabled) {
+	struct allocator_stats mem_stats;
+	struct queue_stats queue_stats;
+	int var = 10;
+	allocator_new(&mem, 8);
+	queue_push(&queue, &var);
+	allocator_stats_get(&mem, &mem_stats);
+	queue_stats_get(&queue, &queue_stats);
+	ASSERT_EQ(mem_stats.new_cycles.count, 0);
+	ASSERT_EQ(queue_stats.push_cycles.count, 0);
+	ASSERT_EQ(queue_stats.high_water, 0);
+}
+#endif
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+/*
+ * This file is part of boislib,
+ * a Collection of portable libraries to extended the C ecosystem.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "boislib/ws_deque.h"
+
+constexpr unsigned int ws_tasks = 64;
+
+class WsDequeTests : public testing::Test {
+	protected:
+	struct ws_deque* deque;
+	uint64_t* buf;
+	uintptr_t tasks[ws_tasks];
+
+	void SetUp() override {
+		size_t size = ws_deque_footprint(ws_tasks);
+		buf = new uint64_t[size / sizeof(uint64_t)];
+		deque = ws_deque_init(buf, size);
+		for (unsigned int i = 0; i < ws_tasks; i++) {
+			tasks[i] = i;
+		}
+	}
+
+	void TearDown() override { delete[] buf; }
+};
+
+TEST_F(WsDequeTests, Init) {
+	ASSERT_EQ((void*)deque, (void*)buf);
+	ASSERT_EQ(ws_deque_capacity(deque), ws_tasks);
+	ASSERT_EQ(ws_deque_size(deque), 0);
+	ASSERT_EQ(ws_deque_init(buf, sizeof(uint64_t)), nullptr);
+}
+
+TEST_F(WsDequeTests, PopIsLifo) {
+	ASSERT_EQ(ws_deque_pop(deque), nullptr);
+	ASSERT_TRUE(ws_deque_push(deque, &tasks[0]));
+	ASSERT_TRUE(ws_deque_push(deque, &tasks[1]));
+	ASSERT_EQ(ws_deque_size(deque), 2);
+	ASSERT_EQ(ws_deque_pop(deque), &tasks[1]);
+	ASSERT_EQ(ws_deque_pop(deque), &tasks[0]);
+	ASSERT_EQ(ws_deque_pop(deque), nullptr);
+	ASSERT_EQ(ws_deque_size(deque), 0);
+}
+
+TEST_F(WsDequeTests, StealIsFifo) {
+	ASSERT_EQ(ws_deque_steal(deque), nullptr);
+	ASSERT_TRUE(ws_deque_push(deque, &tasks[0]));
+	ASSERT_TRUE(ws_deque_push(deque, &tasks[1]));
+	ASSERT_EQ(ws_deque_steal(deque), &tasks[0]);
+	ASSERT_EQ(ws_deque_pop(deque), &tasks[1]);
+	ASSERT_EQ(ws_deque_steal(deque), nullptr);
+}
+
+TEST_F(WsDequeTests, Full) {
+	unsigned int i;
+	for (i = 0; i < ws_tasks; i++) {
+		ASSERT_TRUE(ws_deque_push(deque, &tasks[i]));
+	}
+	ASSERT_FALSE(ws_deque_push(deque, &tasks[0]));
+	ASSERT_EQ(ws_deque_steal(deque), &tasks[0]);
+	ASSERT_TRUE(ws_deque_push(deque, &tasks[0]));
+}
+
+TEST_F(WsDequeTests, ConcurrentSteal) {
+	constexpr unsigned int total = 200000;
+	constexpr unsigned int thieves = 3;
+	std::vector<std::atomic<uint8_t>> taken(total);
+	std::vector<uintptr_t> items(total);
+	std::atomic<unsigned int> done(0);
+	std::atomic<bool> stop(false);
+
+	auto take = [&](void* task) {
+		taken[*(uintptr_t*)task].fetch_add(1);
+		done.fetch_add(1);
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < thieves; t++) {
+		threads.emplace_back([&]() {
+			while (!stop.load()) {
+				void* task = ws_deque_steal(deque);
+				if (task != NULL)
+					take(task);
+				else
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	/* the owner pushes everything and pops every other round */
+	for (unsigned int i = 0; i < total; i++) {
+		items[i] = i;
+		while (!ws_deque_push(deque, &items[i])) {
+			void* task = ws_deque_pop(deque);
+			if (task != NULL)
+				take(task);
+		}
+		if (i % 2 == 0) {
+			void* task = ws_deque_pop(deque);
+			if (task != NULL)
+				take(task);
+		}
+	}
+	void* task;
+	while ((task = ws_deque_pop(deque)) != NULL) {
+		take(task);
+	}
+	while (done.load() < total) {
+		std::this_thread::yield();
+	}
+	stop.store(true);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (unsigned int i = 0; i < total; i++) {
+		ASSERT_EQ(taken[i].load(), 1);
+	}
+}